@@ -1,5 +1,8 @@
 #include "apu/apu.h"
 #include "memory/memory.h"
+#include "cpu/cpu.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
 namespace nes {
@@ -29,28 +32,72 @@ const uint8_t APU::DUTY_TABLE[4][8] = {
     {1, 0, 0, 1, 1, 1, 1, 1}
 };
 
+namespace {
+
+// Bảng mixer tính một lần khi khởi động (công thức nonlinear của nesdev)
+struct MixerTables {
+    int32_t pulse[31];
+    int32_t tnd[203];
+
+    MixerTables() {
+        pulse[0] = 0;
+        for (int n = 1; n < 31; n++) {
+            pulse[n] = static_cast<int32_t>(std::lround(95.52 / (8128.0 / n + 100.0) * 65536.0));
+        }
+        tnd[0] = 0;
+        for (int n = 1; n < 203; n++) {
+            tnd[n] = static_cast<int32_t>(std::lround(163.67 / (24329.0 / n + 100.0) * 65536.0));
+        }
+    }
+};
+
+const MixerTables MIXER_TABLES;
+
+} // namespace
+
+const int32_t* const APU::PULSE_MIX = MIXER_TABLES.pulse;
+const int32_t* const APU::TND_MIX = MIXER_TABLES.tnd;
+
 // DMC Rate Lookup Table (NTSC)
 const uint16_t APU::DMC_RATE_TABLE[16] = {
     428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54
 };
 
+// Frame sequencer (NTSC). 4-step: IRQ flag set ở 3 cycle cuối, 5-step: không IRQ.
+// Mode 1 chỉ có 5 entry, entry cuối không dùng.
+const APU::FrameEvent APU::FRAME_SEQUENCE[2][6] = {
+    {
+        {7457, FRAME_QUARTER},
+        {14913, FRAME_QUARTER | FRAME_HALF},
+        {22371, FRAME_QUARTER},
+        {29828, FRAME_IRQ},
+        {29829, FRAME_QUARTER | FRAME_HALF | FRAME_IRQ},
+        {29830, FRAME_IRQ | FRAME_WRAP}
+    },
+    {
+        {7457, FRAME_QUARTER},
+        {14913, FRAME_QUARTER | FRAME_HALF},
+        {22371, FRAME_QUARTER},
+        {37281, FRAME_QUARTER | FRAME_HALF},
+        {37282, FRAME_WRAP},
+        {0, 0}
+    }
+};
+
 APU::APU() 
     : frame_counter_mode_(0), irq_inhibit_(false),
+      frame_irq_flag_(false), irq_line_(false),
       enable_pulse1_(false), enable_pulse2_(false),
       enable_triangle_(false), enable_noise_(false), enable_dmc_(false),
-      cycle_count_(0), frame_step_(0) {
+      cycle_count_(0), pending_cycles_(0), odd_cycle_(false), frame_step_(0),
+      frame_start_(0), next_frame_event_(0), dmc_next_cycle_(0), next_event_(0) {
       
       memory_ = nullptr;
+      cpu_ = nullptr;
+      channel_capture_ = false;
     
-    // Initialize channels
-    std::memset(&pulse1_, 0, sizeof(PulseChannel));
-    std::memset(&pulse2_, 0, sizeof(PulseChannel));
-    std::memset(&triangle_, 0, sizeof(TriangleChannel));
-    std::memset(&noise_, 0, sizeof(NoiseChannel));
-    std::memset(&dmc_, 0, sizeof(DMCChannel));
-    
-    noise_.shift_register = 1; // Must not be 0
-    dmc_.buffer_empty = true;
+    set_sample_rate(44100.0);
+    reset();
 }
 
 APU::~APU() {
@@ -58,18 +105,26 @@ APU::~APU() {
 
 void APU::connect_memory(Memory* memory) {
     memory_ = memory;
+    dmc_pages_valid_ = false;
+}
+
+void APU::connect_cpu(CPU* cpu) {
+    cpu_ = cpu;
 }
 
 void APU::reset() {
     frame_counter_mode_ = 0;
     irq_inhibit_ = false;
+    frame_irq_flag_ = false;
+    irq_line_ = false;
     enable_pulse1_ = false;
     enable_pulse2_ = false;
     enable_triangle_ = false;
     enable_noise_ = false;
     enable_dmc_ = false;
     cycle_count_ = 0;
-    frame_step_ = 0;
+    pending_cycles_ = 0;
+    odd_cycle_ = false;
     
     std::memset(&pulse1_, 0, sizeof(PulseChannel));
     std::memset(&pulse2_, 0, sizeof(PulseChannel));
@@ -77,73 +132,212 @@ void APU::reset() {
     std::memset(&noise_, 0, sizeof(NoiseChannel));
     std::memset(&dmc_, 0, sizeof(DMCChannel));
     
-    noise_.shift_register = 1;
+    noise_.shift_register = 1; // Must not be 0
     dmc_.buffer_empty = true;
+    dmc_.timer_period = DMC_RATE_TABLE[0];
+    dmc_pages_valid_ = false;
+    
+    // Sequence bắt đầu từ cycle 0 như sau khi ghi $4017 = $00
+    frame_step_ = 0;
+    frame_start_ = 0;
+    next_frame_event_ = FRAME_SEQUENCE[0][0].cycle;
+    dmc_next_cycle_ = dmc_.timer_period;
+    update_next_event();
+    
+    for (AudioFilter& filter : filters_) {
+        filter.reset();
+    }
+    clear_channel_streams();
+}
+
+void APU::set_sample_rate(double sample_rate) {
+    filters_[0].configure(AudioFilter::HIGH_PASS, 90.0, sample_rate);
+    filters_[1].configure(AudioFilter::HIGH_PASS, 440.0, sample_rate);
+    filters_[2].configure(AudioFilter::LOW_PASS, 14000.0, sample_rate);
 }
 
-void APU::step() {
-    cycle_count_++;
+void APU::set_channel_capture(bool enabled, size_t capacity) {
+    channel_capture_ = enabled;
+    for (std::vector<float>& stream : channel_streams_) {
+        stream.clear();
+        if (enabled) {
+            stream.reserve(capacity);
+        } else {
+            stream.shrink_to_fit();
+        }
+    }
+}
+
+void APU::clear_channel_streams() {
+    for (std::vector<float>& stream : channel_streams_) {
+        stream.clear();
+    }
+}
+
+void APU::catch_up() {
+    if (pending_cycles_ == 0) return;
+    uint64_t target = cycle_count_ + pending_cycles_;
+    pending_cycles_ = 0;
+    run_until(target);
+}
+
+void APU::run_until(uint64_t target) {
+    while (cycle_count_ < target) {
+        uint64_t end = std::min(target, next_event_);
+        advance_channels(end - cycle_count_);
+        cycle_count_ = end;
+        
+        if (cycle_count_ >= next_event_) {
+            run_events();
+        }
+    }
+}
+
+void APU::advance_channels(uint64_t cycles) {
+    // Pulse channels clock every 2 CPU cycles (trên cycle chẵn)
+    uint64_t apu_clocks = (cycles + (odd_cycle_ ? 1 : 0)) / 2;
+    odd_cycle_ ^= (cycles & 1) != 0;
+    pulse1_.advance_timer(apu_clocks);
+    pulse2_.advance_timer(apu_clocks);
     
-    // Pulse channels clock every 2 CPU cycles
-    if (cycle_count_ % 2 == 0) {
-        pulse1_.step_timer();
-        pulse2_.step_timer();
-        noise_.step_timer();
-        dmc_.step_timer(memory_);
+    // Triangle + noise clock every CPU cycle (noise period table tính theo CPU cycles)
+    triangle_.advance_timer(cycles);
+    noise_.advance_timer(cycles);
+}
+
+void APU::run_events() {
+    if (dmc_.active() && cycle_count_ >= dmc_next_cycle_) {
+        dmc_.step_output();
+        if (dmc_.buffer_empty && dmc_.bytes_remaining > 0) {
+            dmc_fetch();
+        }
+        dmc_next_cycle_ += dmc_.timer_period;
+        update_irq_line();
+    }
+    if (cycle_count_ >= next_frame_event_) {
+        step_frame_counter();
+    }
+    update_next_event();
+}
+
+void APU::update_next_event() {
+    // DMC im: không cần dừng ở output clock, timer được sync lại khi phát
+    next_event_ = dmc_.active() ? std::min(next_frame_event_, dmc_next_cycle_) : next_frame_event_;
+}
+
+void APU::dmc_fetch() {
+    if (!dmc_pages_valid_) {
+        resolve_prg_pages();
     }
     
-    // Triangle clocks every CPU cycle
-    triangle_.step_timer();
+    // DMC chỉ đọc $8000-$FFFF
+    uint16_t address = dmc_.current_address;
+    const uint8_t* page = dmc_pages_[(address >> 13) & 0x03];
+    if (page) {
+        dmc_.sample_buffer = page[address & 0x1FFF];
+    } else if (memory_) {
+        dmc_.sample_buffer = memory_->read(address);
+    } else {
+        return;
+    }
+    dmc_.buffer_empty = false;
     
-    // Noise timer is clocked every CPU cycle, but decrements based on period
-    noise_.step_timer();
+    // Address increment logic: wraps 0xFFFF -> 0x8000
+    if (dmc_.current_address == 0xFFFF) {
+        dmc_.current_address = 0x8000;
+    } else {
+        dmc_.current_address++;
+    }
     
-    // Frame Counter Step (approx 7457 cycles)
-    if (cycle_count_ % 7457 == 0) {
-        step_frame_counter();
+    dmc_.bytes_remaining--;
+    
+    if (dmc_.bytes_remaining == 0) {
+        if (dmc_.loop) {
+            dmc_.restart();
+        } else if (dmc_.irq_enabled) {
+            dmc_.irq_pending = true;
+        }
+    }
+    
+    // DMA đọc sample chiếm bus: CPU dừng 4 cycles (trường hợp thường gặp)
+    if (cpu_) {
+        cpu_->add_stall_cycles(4);
+    }
+}
+
+void APU::resolve_prg_pages() {
+    for (int i = 0; i < 4; i++) {
+        dmc_pages_[i] = memory_ ? memory_->get_prg_page(0x8000 + i * 0x2000) : nullptr;
+    }
+    dmc_pages_valid_ = true;
+}
+
+void APU::sync_dmc_timer() {
+    if (dmc_next_cycle_ <= cycle_count_) {
+        uint64_t behind = cycle_count_ - dmc_next_cycle_;
+        dmc_next_cycle_ += (behind / dmc_.timer_period + 1) * dmc_.timer_period;
     }
 }
 
 void APU::step_frame_counter() {
-    frame_step_++;
+    const FrameEvent& event = FRAME_SEQUENCE[frame_counter_mode_][frame_step_];
+    
+    if (event.flags & FRAME_QUARTER) {
+        clock_quarter_frame();
+    }
+    if (event.flags & FRAME_HALF) {
+        clock_half_frame();
+    }
+    if ((event.flags & FRAME_IRQ) && !irq_inhibit_) {
+        frame_irq_flag_ = true;
+        update_irq_line();
+    }
     
-    // Envelope & Linear Counter (Every step)
+    if (event.flags & FRAME_WRAP) {
+        frame_start_ += event.cycle;
+        frame_step_ = 0;
+    } else {
+        frame_step_++;
+    }
+    next_frame_event_ = frame_start_ + FRAME_SEQUENCE[frame_counter_mode_][frame_step_].cycle;
+}
+
+void APU::clock_quarter_frame() {
+    // Envelope & Linear Counter
     pulse1_.step_envelope();
     pulse2_.step_envelope();
     triangle_.step_linear();
     noise_.step_envelope();
+}
+
+void APU::clock_half_frame() {
+    // Length & Sweep
+    pulse1_.step_length();
+    pulse1_.step_sweep(false);
     
-    // Length & Sweep (Every 2 steps: 2, 4)
-    if (frame_step_ == 2 || frame_step_ == 4) {
-        pulse1_.step_length();
-        pulse1_.step_sweep(false);
-        
-        pulse2_.step_length();
-        pulse2_.step_sweep(true);
-        
-        triangle_.step_length();
-        noise_.step_length();
-    }
+    pulse2_.step_length();
+    pulse2_.step_sweep(true);
     
-    // Reset step
-    if (frame_counter_mode_ == 0) {
-        if (frame_step_ >= 4) frame_step_ = 0;
-    } else {
-        if (frame_step_ >= 5) frame_step_ = 0;
-    }
+    triangle_.step_length();
+    noise_.step_length();
 }
 
 uint8_t APU::read_register(uint16_t address) {
     if (address == 0x4015) {
+        catch_up();
+        
         uint8_t value = 0;
         if (pulse1_.length_counter > 0) value |= 0x01;
         if (pulse2_.length_counter > 0) value |= 0x02;
         if (triangle_.length_counter > 0) value |= 0x04;
         if (noise_.length_counter > 0) value |= 0x08;
         if (dmc_.bytes_remaining > 0) value |= 0x10;
+        if (frame_irq_flag_) value |= 0x40;
+        if (dmc_.irq_pending) value |= 0x80;
         
-        // TODO: Frame interrupt flag
-        // TODO: DMC interrupt flag
+        // Đọc $4015 xóa frame interrupt flag (không xóa DMC)
+        frame_irq_flag_ = false;
+        update_irq_line();
         
         return value;
     }
@@ -151,6 +345,9 @@ uint8_t APU::read_register(uint16_t address) {
 }
 
 void APU::write_register(uint16_t address, uint8_t value) {
+    // Channel phải ở đúng cycle ghi trước khi đổi state
+    catch_up();
+    
     switch (address) {
         // ... Pulse/Triangle/Noise cases (unchanged) ...
         // Pulse 1
@@ -246,8 +443,10 @@ void APU::write_register(uint16_t address, uint8_t value) {
             dmc_.irq_enabled = (value & 0x80) != 0;
             dmc_.loop = (value & 0x40) != 0;
             dmc_.rate_index = value & 0x0F;
+            sync_dmc_timer();  // Phần đã qua chạy theo rate cũ
             dmc_.timer_period = DMC_RATE_TABLE[dmc_.rate_index];
             if (!dmc_.irq_enabled) dmc_.irq_pending = false;
+            update_irq_line();
             break;
         case 0x4011:
             dmc_.direct_load = value & 0x7F;
@@ -279,37 +478,68 @@ void APU::write_register(uint16_t address, uint8_t value) {
                 }
             } else {
                 dmc_.bytes_remaining = 0;
-                dmc_.irq_pending = false;
             }
+            
+            // Ghi $4015 luôn xóa DMC interrupt flag
+            dmc_.irq_pending = false;
+            update_irq_line();
+            sync_dmc_timer();
+            update_next_event();
             break;
             
         // Frame Counter
         case 0x4017:
             frame_counter_mode_ = (value & 0x80) >> 7;
             irq_inhibit_ = (value & 0x40) != 0;
+            if (irq_inhibit_) {
+                frame_irq_flag_ = false;
+                update_irq_line();
+            }
+            
+            // Sequence reset sau 3 (ghi trong APU cycle) hoặc 4 CPU cycles
             frame_step_ = 0;
+            frame_start_ = cycle_count_ + (odd_cycle_ ? 4 : 3);
+            next_frame_event_ = frame_start_ + FRAME_SEQUENCE[frame_counter_mode_][0].cycle;
+            update_next_event();
+            
+            // 5-step: clock quarter + half frame ngay lập tức
             if (frame_counter_mode_ == 1) {
-                step_frame_counter();
+                clock_quarter_frame();
+                clock_half_frame();
             }
             break;
     }
 }
 
 float APU::get_sample() const {
-    // Mixer: linear approximation
-    // Pulse Out = 0.00752 * (Pulse1 + Pulse2)
-    // TND Out = 0.00851 * Triangle + 0.00494 * Noise + 0.00335 * DMC
+    int32_t mixed = PULSE_MIX[pulse1_.output() + pulse2_.output()] +
+                    TND_MIX[3 * triangle_.output() + 2 * noise_.output() + dmc_.output()];
+    return mixed / 65536.0f;
+}
+
+float APU::mix_sample() {
+    uint8_t p1 = pulse1_.output();
+    uint8_t p2 = pulse2_.output();
+    uint8_t tr = triangle_.output();
+    uint8_t ns = noise_.output();
+    uint8_t dm = dmc_.output();
     
-    uint8_t p1 = const_cast<PulseChannel&>(pulse1_).output();
-    uint8_t p2 = const_cast<PulseChannel&>(pulse2_).output();
-    uint8_t tr = const_cast<TriangleChannel&>(triangle_).output();
-    uint8_t ns = const_cast<NoiseChannel&>(noise_).output();
-    uint8_t dm = const_cast<DMCChannel&>(dmc_).output();
+    int32_t mixed = PULSE_MIX[p1 + p2] + TND_MIX[3 * tr + 2 * ns + dm];
     
-    float pulse_out = 0.00752f * (p1 + p2);
-    float tnd_out = 0.00851f * tr + 0.00494f * ns + 0.00335f * dm;
+    // Stem = channel đi một mình qua nửa mixer của nó (tổng các stem ~ mixed,
+    // không bằng hẳn vì mixer phi tuyến)
+    if (channel_capture_ && channel_streams_[0].size() < channel_streams_[0].capacity()) {
+        channel_streams_[CHANNEL_PULSE1].push_back(PULSE_MIX[p1] / 65536.0f);
+        channel_streams_[CHANNEL_PULSE2].push_back(PULSE_MIX[p2] / 65536.0f);
+        channel_streams_[CHANNEL_TRIANGLE].push_back(TND_MIX[3 * tr] / 65536.0f);
+        channel_streams_[CHANNEL_NOISE].push_back(TND_MIX[2 * ns] / 65536.0f);
+        channel_streams_[CHANNEL_DMC].push_back(TND_MIX[dm] / 65536.0f);
+    }
     
-    return pulse_out + tnd_out;
+    for (AudioFilter& filter : filters_) {
+        mixed = filter.process(mixed);
+    }
+    return mixed / 65536.0f;
 }
 
 // ... Pulse/Triangle/Noise implementations (unchanged) ...
@@ -317,7 +547,7 @@ float APU::get_sample() const {
 // Pulse Channel Implementation
 // ==========================================
 
-uint8_t APU::PulseChannel::output() {
+uint8_t APU::PulseChannel::output() const {
     if (length_counter == 0) return 0;
     if (DUTY_TABLE[duty_mode][duty_sequence] == 0) return 0;
     if (timer_period < 8) return 0;
@@ -330,13 +560,17 @@ uint8_t APU::PulseChannel::output() {
     }
 }
 
-void APU::PulseChannel::step_timer() {
-    if (timer_value == 0) {
-        timer_value = timer_period;
-        duty_sequence = (duty_sequence + 1) & 0x07;
-    } else {
-        timer_value--;
+void APU::PulseChannel::advance_timer(uint64_t clocks) {
+    // Timer đếm timer_value -> 0, clock tại 0 reload period và tiến duty sequence:
+    // mỗi (timer_period + 1) clocks là một bước sequence
+    if (clocks <= timer_value) {
+        timer_value -= clocks;
+        return;
     }
+    clocks -= timer_value + 1;
+    uint64_t reload = (uint64_t)timer_period + 1;
+    duty_sequence = (duty_sequence + 1 + clocks / reload) & 0x07;
+    timer_value = timer_period - clocks % reload;
 }
 
 void APU::PulseChannel::step_envelope() {
@@ -396,19 +630,23 @@ void APU::PulseChannel::calculate_sweep_target(bool is_pulse2) {
 // Triangle Channel Implementation
 // ==========================================
 
-uint8_t APU::TriangleChannel::output() {
+uint8_t APU::TriangleChannel::output() const {
     if (length_counter == 0 || linear_counter == 0) return 0;
     return TRIANGLE_SEQUENCE[sequence_index];
 }
 
-void APU::TriangleChannel::step_timer() {
-    if (timer_value == 0) {
-        timer_value = timer_period;
-        if (length_counter > 0 && linear_counter > 0) {
-            sequence_index = (sequence_index + 1) & 0x1F;
-        }
-    } else {
-        timer_value--;
+void APU::TriangleChannel::advance_timer(uint64_t clocks) {
+    if (clocks <= timer_value) {
+        timer_value -= clocks;
+        return;
+    }
+    clocks -= timer_value + 1;
+    uint64_t reload = (uint64_t)timer_period + 1;
+    timer_value = timer_period - clocks % reload;
+    
+    // Counter chỉ đổi ở frame event / register write (= điểm dừng của catch-up)
+    if (length_counter > 0 && linear_counter > 0) {
+        sequence_index = (sequence_index + 1 + clocks / reload) & 0x1F;
     }
 }
 
@@ -434,7 +672,7 @@ void APU::TriangleChannel::step_length() {
 // Noise Channel Implementation
 // ==========================================
 
-uint8_t APU::NoiseChannel::output() {
+uint8_t APU::NoiseChannel::output() const {
     if (length_counter == 0) return 0;
     if (shift_register & 0x01) return 0; // Bit 0 determines output
     
@@ -445,21 +683,24 @@ uint8_t APU::NoiseChannel::output() {
     }
 }
 
-void APU::NoiseChannel::step_timer() {
-    if (timer_value == 0) {
-        timer_value = timer_period;
-        
-        uint8_t feedback;
-        if (mode) {
-            feedback = (shift_register & 0x01) ^ ((shift_register >> 6) & 0x01);
-        } else {
-            feedback = (shift_register & 0x01) ^ ((shift_register >> 1) & 0x01);
-        }
-        
+void APU::NoiseChannel::advance_timer(uint64_t clocks) {
+    if (clocks <= timer_value) {
+        timer_value -= clocks;
+        return;
+    }
+    clocks -= timer_value + 1;
+    uint64_t reload = (uint64_t)timer_period + 1;
+    uint64_t shifts = 1 + clocks / reload;
+    timer_value = timer_period - clocks % reload;
+    
+    // Channel im: pha của LFSR không nghe được, bỏ qua thay vì shift từng bước
+    if (length_counter == 0) return;
+    
+    int tap = mode ? 6 : 1;
+    for (uint64_t i = 0; i < shifts; i++) {
+        uint16_t feedback = (shift_register ^ (shift_register >> tap)) & 0x01;
         shift_register >>= 1;
         shift_register |= (feedback << 14);
-    } else {
-        timer_value--;
     }
 }
 
@@ -492,20 +733,11 @@ void APU::NoiseChannel::step_length() {
 // DMC Channel Implementation
 // ==========================================
 
-uint8_t APU::DMCChannel::output() {
+uint8_t APU::DMCChannel::output() const {
     return output_level;
 }
 
-void APU::DMCChannel::step_timer(Memory* memory) {
-    if (timer_value == 0) {
-        timer_value = timer_period;
-        step_reader(memory);
-    } else {
-        timer_value--;
-    }
-}
-
-void APU::DMCChannel::step_reader(Memory* memory) {
+void APU::DMCChannel::step_output() {
     if (!buffer_empty) {
         // Output cycle
         if (bits_remaining <= 0) {
@@ -525,29 +757,6 @@ void APU::DMCChannel::step_reader(Memory* memory) {
             bits_remaining--;
         }
     }
-    
-    // Fetch cycle (if buffer empty and bytes remaining)
-    if (buffer_empty && bytes_remaining > 0 && memory) {
-        sample_buffer = memory->read(current_address);
-        buffer_empty = false;
-        
-        // Address increment logic: wraps 0xFFFF -> 0x8000
-        if (current_address == 0xFFFF) {
-            current_address = 0x8000;
-        } else {
-            current_address++;
-        }
-        
-        bytes_remaining--;
-        
-        if (bytes_remaining == 0) {
-            if (loop) {
-                restart();
-            } else if (irq_enabled) {
-                irq_pending = true;
-            }
-        }
-    }
 }
 
 void APU::DMCChannel::restart() {
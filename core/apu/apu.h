@@ -2,10 +2,14 @@
 #define NES_APU_H
 
 #include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "apu/audio_filter.h"
 
 namespace nes {
 
 class Memory;
+class CPU;
 
 /**
  * @brief NES Audio Processing Unit (Ricoh 2A03 APU)
@@ -19,6 +23,18 @@ class Memory;
  */
 class APU {
 public:
+    /**
+     * @brief Index của từng channel trong per-channel stream
+     */
+    enum Channel {
+        CHANNEL_PULSE1,
+        CHANNEL_PULSE2,
+        CHANNEL_TRIANGLE,
+        CHANNEL_NOISE,
+        CHANNEL_DMC,
+        CHANNEL_COUNT
+    };
+
     APU();
     ~APU();
 
@@ -28,10 +44,24 @@ public:
     void reset();
 
     /**
-     * @brief Run one APU cycle (called every CPU cycle)
-     * Note: APU runs at CPU frequency, but some components run at half speed.
+     * @brief Báo APU thêm CPU cycles đã trôi qua (gọi sau mỗi CPU step)
+     *
+     * APU chạy lazy: chỉ cộng dồn, channel được đưa tới cycle hiện tại khi cần
+     * (catch_up). Riêng event có thể đổi IRQ line / đọc memory (frame sequencer,
+     * DMC đang phát) được chạy đúng cycle của nó.
+     */
+    void add_cycles(int cycles) {
+        pending_cycles_ += cycles;
+        if (cycle_count_ + pending_cycles_ >= next_event_) {
+            catch_up();
+        }
+    }
+
+    /**
+     * @brief Chạy APU tới cycle hiện tại (trước khi đọc sample / cuối frame)
+     * Register access ($4000-$4017) tự gọi hàm này.
      */
-    void step();
+    void catch_up();
 
     /**
      * @brief Read from APU register ($4000-$4017)
@@ -45,14 +75,59 @@ public:
 
     /**
      * @brief Get current audio sample (0.0 to 1.0)
-     * Used by the audio backend (SDL) to play sound.
+     * Output của mixer phi tuyến, chưa qua filter.
      */
     float get_sample() const;
 
+    /**
+     * @brief Tạo 1 output sample (gọi ở mỗi điểm sample, sau catch_up)
+     *
+     * Mixer phi tuyến (LUT) → per-channel stream (nếu bật) → high-pass 90 Hz,
+     * high-pass 440 Hz, low-pass 14 kHz (fixed point).
+     * Used by the audio backend (SDL) to play sound.
+     * @return Sample đã lọc, quanh 0 (khoảng -1.0 to 1.0)
+     */
+    float mix_sample();
+
+    /**
+     * @brief Sample rate của output (tính lại hệ số filter)
+     */
+    void set_sample_rate(double sample_rate);
+
+    /**
+     * @brief Bật/tắt ghi per-channel stream (visualizer, phân tích, export stem)
+     * @param capacity Số samples cấp phát trước cho mỗi channel; stream không
+     *                 cấp phát thêm, sample vượt quá capacity bị bỏ
+     */
+    void set_channel_capture(bool enabled, size_t capacity = 0);
+    bool is_channel_capture_enabled() const { return channel_capture_; }
+
+    /**
+     * @brief Đóng góp của channel vào output (qua nửa mixer tương ứng, 0.0 to 1.0)
+     * Một sample cho mỗi lần mix_sample() kể từ clear_channel_streams().
+     */
+    const std::vector<float>& get_channel_stream(Channel channel) const { return channel_streams_[channel]; }
+    void clear_channel_streams();
+
+    /**
+     * @brief IRQ line của APU (frame IRQ | DMC IRQ), nối vào CPU::connect_irq_line
+     */
+    const bool* get_irq_line() const { return &irq_line_; }
+
+    /**
+     * @brief PRG bank có thể đã đổi (ghi mapper $8000-$FFFF, load ROM)
+     * Con trỏ page của DMC được resolve lại ở lần fetch sau.
+     */
+    void invalidate_prg_pages() { dmc_pages_valid_ = false; }
+
 private:
     // Frame Counter ($4017)
     uint8_t frame_counter_mode_;
     bool irq_inhibit_;
+    bool frame_irq_flag_;
+    
+    // frame_irq_flag_ || dmc_.irq_pending (level-triggered)
+    bool irq_line_;
     
     // Status Register ($4015)
     bool enable_pulse1_;
@@ -63,9 +138,20 @@ private:
     
     // Internal cycle counter
     uint64_t cycle_count_;
+    uint64_t pending_cycles_;  // Cycles đã qua nhưng channel chưa được chạy tới
+    bool odd_cycle_;     // Pulse timers clock on even CPU cycles (APU cycle)
     
     // Frame Counter
-    uint8_t frame_step_; // 0-4 or 0-5
+    uint8_t frame_step_;          // Index trong FRAME_SEQUENCE[mode]
+    uint64_t frame_start_;        // cycle_count_ khi sequence bắt đầu (sau $4017 / wrap)
+    uint64_t next_frame_event_;   // frame_start_ + FRAME_SEQUENCE[mode][frame_step_].cycle
+    
+    // DMC output unit clock (mỗi dmc_.timer_period CPU cycles)
+    uint64_t dmc_next_cycle_;
+    
+    // min(next_frame_event_, dmc_next_cycle_ nếu DMC đang phát): add_cycles() chỉ
+    // so sánh với giá trị này
+    uint64_t next_event_;
     
     // ==========================================
     // Pulse Channel Structure
@@ -112,8 +198,8 @@ private:
         bool sweep_mute;            // Mute flag
         
         // Output
-        uint8_t output();
-        void step_timer();
+        uint8_t output() const;
+        void advance_timer(uint64_t clocks);
         void step_envelope();
         void step_length();
         void step_sweep(bool is_pulse2);
@@ -148,8 +234,8 @@ private:
         uint8_t length_counter;
         uint8_t sequence_index; // 0-31
         
-        uint8_t output();
-        void step_timer();
+        uint8_t output() const;
+        void advance_timer(uint64_t clocks);
         void step_linear();
         void step_length();
     };
@@ -186,8 +272,8 @@ private:
         uint8_t envelope_volume;
         bool envelope_start;
         
-        uint8_t output();
-        void step_timer();
+        uint8_t output() const;
+        void advance_timer(uint64_t clocks);
         void step_envelope();
         void step_length();
     };
@@ -221,18 +307,19 @@ private:
         bool buffer_empty;
         uint8_t shift_register;
         uint8_t bits_remaining;
-        uint16_t timer_value;
-        uint16_t timer_period;
+        uint16_t timer_period;  // CPU cycles giữa 2 lần clock output unit
         bool silence;
         uint8_t output_level; // 0-127
         
         // IRQ
         bool irq_pending;
         
-        uint8_t output();
-        void step_timer(Memory* memory);
-        void step_reader(Memory* memory);
+        uint8_t output() const;
+        void step_output();
         void restart();
+        
+        // false: step_output() / dmc_fetch() không làm gì, timer chạy closed-form
+        bool active() const { return !buffer_empty || bytes_remaining > 0; }
     };
     
     DMCChannel dmc_;
@@ -252,14 +339,69 @@ private:
     // Triangle Sequence
     static const uint8_t TRIANGLE_SEQUENCE[32];
     
+    // Mixer phi tuyến (Q16, 65536 = 1.0):
+    // PULSE_MIX[p1 + p2] = 95.52 / (8128 / n + 100)
+    // TND_MIX[3 * triangle + 2 * noise + dmc] = 163.67 / (24329 / n + 100)
+    static const int32_t* const PULSE_MIX;  // 31 entries
+    static const int32_t* const TND_MIX;    // 203 entries
+    
+    // Output filter chain (theo mạch output của NES)
+    static constexpr int FILTER_COUNT = 3;
+    AudioFilter filters_[FILTER_COUNT];
+    
+    // Per-channel streams (preallocated, tắt mặc định)
+    bool channel_capture_;
+    std::vector<float> channel_streams_[CHANNEL_COUNT];
+    
+    // Frame sequencer (NTSC, CPU cycles tính từ đầu sequence)
+    enum FrameEventFlags : uint8_t {
+        FRAME_QUARTER = 0x01,  // Envelope + triangle linear counter
+        FRAME_HALF = 0x02,     // Length counter + sweep
+        FRAME_IRQ = 0x04,      // Set frame IRQ flag (4-step, nếu không inhibit)
+        FRAME_WRAP = 0x08      // Sequence bắt đầu lại
+    };
+    struct FrameEvent {
+        uint32_t cycle;
+        uint8_t flags;
+    };
+    static const FrameEvent FRAME_SEQUENCE[2][6];
+    
+    // Chạy channel tới target, dừng ở từng event để xử lý
+    void run_until(uint64_t target);
+    
+    // Timer của các channel chạy `cycles` CPU cycles (closed form, không lặp)
+    void advance_channels(uint64_t cycles);
+    
+    // Chạy các event đã tới hạn (frame sequencer, DMC) và tính next_event_
+    void run_events();
+    void update_next_event();
+    
+    // Đưa dmc_next_cycle_ (bị bỏ lại khi DMC im) lên sau cycle hiện tại, giữ pha
+    void sync_dmc_timer();
+    
+    // DMC đọc 1 byte sample vào buffer (qua page pointer), CPU bị stall 4 cycles
+    void dmc_fetch();
+    void resolve_prg_pages();
+    
     // Helper to clock frame counter
     void step_frame_counter();
+    void clock_quarter_frame();
+    void clock_half_frame();
+    
+    void update_irq_line() { irq_line_ = frame_irq_flag_ || dmc_.irq_pending; }
     
     // Memory access for DMC
     Memory* memory_;
+    CPU* cpu_;
+    
+    // PRG ROM đang map ở $8000-$FFFF theo page 8KB (nullptr: không phải ROM,
+    // đọc qua memory_). Chỉ resolve lại sau invalidate_prg_pages().
+    const uint8_t* dmc_pages_[4];
+    bool dmc_pages_valid_;
     
 public:
     void connect_memory(Memory* memory);
+    void connect_cpu(CPU* cpu);
 };
 
 } // namespace nes
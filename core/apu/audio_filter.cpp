@@ -0,0 +1,21 @@
+#include "apu/audio_filter.h"
+#include <cmath>
+
+namespace nes {
+
+AudioFilter::AudioFilter()
+    : type_(LOW_PASS), coeff_(1 << SHIFT), prev_in_(0), prev_out_(0) {
+}
+
+void AudioFilter::configure(Type type, double cutoff_hz, double sample_rate) {
+    const double PI = 3.14159265358979323846;
+    double rc = 1.0 / (2.0 * PI * cutoff_hz);
+    double dt = 1.0 / sample_rate;
+    double coeff = (type == HIGH_PASS) ? rc / (rc + dt) : dt / (rc + dt);
+
+    type_ = type;
+    coeff_ = static_cast<int32_t>(std::lround(coeff * (1 << SHIFT)));
+    reset();
+}
+
+} // namespace nes
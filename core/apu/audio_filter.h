@@ -0,0 +1,61 @@
+#ifndef NES_AUDIO_FILTER_H
+#define NES_AUDIO_FILTER_H
+
+#include <cstdint>
+
+namespace nes {
+
+/**
+ * @brief Filter RC bậc 1, fixed point
+ *
+ * Sample và hệ số đều là Q16 (65536 = 1.0), trạng thái giữ trong int32 nên
+ * không tích luỹ sai số float và cho kết quả giống nhau trên mọi máy.
+ * Output của NES đi qua chuỗi: high-pass 90 Hz → high-pass 440 Hz → low-pass 14 kHz.
+ */
+class AudioFilter {
+public:
+    enum Type {
+        HIGH_PASS,
+        LOW_PASS
+    };
+
+    AudioFilter();
+
+    /**
+     * @brief Tính hệ số cho tần số cắt ở sample rate đã cho (reset trạng thái)
+     */
+    void configure(Type type, double cutoff_hz, double sample_rate);
+
+    void reset() {
+        prev_in_ = 0;
+        prev_out_ = 0;
+    }
+
+    /**
+     * @brief Lọc 1 sample Q16
+     */
+    int32_t process(int32_t in) {
+        if (type_ == HIGH_PASS) {
+            // y[n] = a * (y[n-1] + x[n] - x[n-1])
+            prev_out_ = static_cast<int32_t>((static_cast<int64_t>(coeff_) * (prev_out_ + in - prev_in_) + ROUND) >> SHIFT);
+        } else {
+            // y[n] = y[n-1] + b * (x[n] - y[n-1])
+            prev_out_ += static_cast<int32_t>((static_cast<int64_t>(coeff_) * (in - prev_out_) + ROUND) >> SHIFT);
+        }
+        prev_in_ = in;
+        return prev_out_;
+    }
+
+private:
+    static constexpr int SHIFT = 16;
+    static constexpr int64_t ROUND = int64_t(1) << (SHIFT - 1);
+
+    Type type_;
+    int32_t coeff_;     // Q16: a = RC / (RC + dt) (high-pass), b = dt / (RC + dt) (low-pass)
+    int32_t prev_in_;
+    int32_t prev_out_;
+};
+
+} // namespace nes
+
+#endif // NES_AUDIO_FILTER_H
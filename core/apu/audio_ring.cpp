@@ -0,0 +1,45 @@
+#include "apu/audio_ring.h"
+#include <algorithm>
+
+namespace nes {
+
+AudioRing::AudioRing(size_t capacity) : write_pos_(0), read_pos_(0) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    buffer_.assign(size, 0.0f);
+    mask_ = size - 1;
+}
+
+size_t AudioRing::push(const float* samples, size_t count) {
+    size_t write = write_pos_.load(std::memory_order_relaxed);
+    size_t read = read_pos_.load(std::memory_order_acquire);
+    size_t free_space = buffer_.size() - (write - read);
+    count = std::min(count, free_space);
+
+    // Copy tối đa 2 đoạn (đoạn cuối buffer + đoạn quay vòng về đầu)
+    size_t start = write & mask_;
+    size_t first = std::min(count, buffer_.size() - start);
+    std::copy(samples, samples + first, buffer_.begin() + start);
+    std::copy(samples + first, samples + count, buffer_.begin());
+
+    write_pos_.store(write + count, std::memory_order_release);
+    return count;
+}
+
+size_t AudioRing::pop(float* out, size_t count) {
+    size_t read = read_pos_.load(std::memory_order_relaxed);
+    size_t write = write_pos_.load(std::memory_order_acquire);
+    count = std::min(count, write - read);
+
+    size_t start = read & mask_;
+    size_t first = std::min(count, buffer_.size() - start);
+    std::copy(buffer_.begin() + start, buffer_.begin() + start + first, out);
+    std::copy(buffer_.begin(), buffer_.begin() + (count - first), out + first);
+
+    read_pos_.store(read + count, std::memory_order_release);
+    return count;
+}
+
+} // namespace nes
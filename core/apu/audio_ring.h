@@ -0,0 +1,96 @@
+#ifndef NES_AUDIO_RING_H
+#define NES_AUDIO_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace nes {
+
+/**
+ * @brief Ring buffer float lock-free, một producer / một consumer
+ *
+ * Producer là thread emulation (push samples sau mỗi frame), consumer là
+ * audio callback của SDL (pop đúng số samples thiết bị cần). Hai index chỉ
+ * tăng, mỗi phía ghi đúng một index nên không cần lock.
+ */
+class AudioRing {
+public:
+    /**
+     * @param capacity Số samples tối đa (làm tròn lên luỹ thừa của 2)
+     */
+    explicit AudioRing(size_t capacity);
+
+    /**
+     * @brief Ghi samples (chỉ gọi từ producer)
+     * @return Số samples đã ghi (ít hơn count nếu ring đầy, phần dư bị bỏ)
+     */
+    size_t push(const float* samples, size_t count);
+
+    /**
+     * @brief Đọc samples (chỉ gọi từ consumer)
+     * @return Số samples đã đọc (ít hơn count nếu underrun)
+     */
+    size_t pop(float* out, size_t count);
+
+    /**
+     * @brief Số samples đang chờ phát
+     */
+    size_t size() const {
+        return write_pos_.load(std::memory_order_acquire) - read_pos_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return buffer_.size(); }
+
+    /**
+     * @brief Bỏ toàn bộ samples đang chờ
+     * Chỉ an toàn khi consumer đang dừng (SDL_LockAudioDevice)
+     */
+    void clear() {
+        read_pos_.store(write_pos_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    std::vector<float> buffer_;
+    size_t mask_;
+
+    // Tách cache line để producer và consumer không tranh nhau
+    alignas(64) std::atomic<size_t> write_pos_;
+    alignas(64) std::atomic<size_t> read_pos_;
+};
+
+/**
+ * @brief Điều khiển tốc độ resample theo mức đầy của ring (dynamic rate control)
+ *
+ * Emulator và sound card chạy theo hai đồng hồ khác nhau. Thay vì để ring
+ * đầy dần / cạn dần, mỗi frame chỉnh tỉ lệ sinh samples trong khoảng
+ * ±max_delta: ring dưới mức target → sinh nhiều hơn, trên target → ít hơn.
+ * Độ lệch ±0.5% không nghe được thay đổi cao độ.
+ */
+class AudioRateControl {
+public:
+    AudioRateControl(size_t target_fill, double max_delta = 0.005)
+        : target_fill_(target_fill), max_delta_(max_delta) {}
+
+    /**
+     * @brief Tỉ lệ sinh samples cho frame tiếp theo (1.0 = đúng sample rate)
+     * @param fill Số samples đang chờ trong ring
+     */
+    double update(size_t fill) const {
+        double error = 1.0 - static_cast<double>(fill) / static_cast<double>(target_fill_);
+        if (error > 1.0) error = 1.0;
+        if (error < -1.0) error = -1.0;
+        return 1.0 + max_delta_ * error;
+    }
+
+    size_t get_target_fill() const { return target_fill_; }
+    void set_target_fill(size_t target_fill) { target_fill_ = target_fill; }
+
+private:
+    size_t target_fill_;
+    double max_delta_;
+};
+
+} // namespace nes
+
+#endif // NES_AUDIO_RING_H
@@ -0,0 +1,122 @@
+#include "apu/resampler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace nes {
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+// Blackman, u trong [-1, 1] (0 ở hai đầu)
+double blackman(double u) {
+    return 0.42 + 0.5 * std::cos(PI * u) + 0.08 * std::cos(2.0 * PI * u);
+}
+
+} // namespace
+
+Resampler::Resampler()
+    : input_rate_(0.0), output_rate_(0.0), quality_(QUALITY_MEDIUM),
+      taps_(0), phases_(0), step_(1.0), position_(0.0) {
+}
+
+void Resampler::configure(double input_rate, double output_rate, Quality quality) {
+    input_rate_ = input_rate;
+    output_rate_ = output_rate;
+    quality_ = quality;
+
+    double rolloff;
+    switch (quality) {
+        case QUALITY_FAST:
+            taps_ = 8;
+            phases_ = 64;
+            rolloff = 0.80;
+            break;
+        case QUALITY_BEST:
+            taps_ = 32;
+            phases_ = 1024;
+            rolloff = 0.94;
+            break;
+        case QUALITY_MEDIUM:
+        default:
+            taps_ = 16;
+            phases_ = 256;
+            rolloff = 0.90;
+            break;
+    }
+
+    // Tần số cắt (cycles / input sample): dưới Nyquist của rate thấp hơn
+    double cutoff = 0.5 * std::min(1.0, output_rate / input_rate) * rolloff;
+    int half = taps_ / 2;
+
+    // Hàng p: output nằm sau sample (half - 1) của cửa sổ một đoạn p / phases_
+    bank_.assign(static_cast<size_t>(phases_ + 1) * taps_, 0.0f);
+    for (int p = 0; p <= phases_; p++) {
+        double frac = static_cast<double>(p) / phases_;
+        float* row = &bank_[static_cast<size_t>(p) * taps_];
+
+        double sum = 0.0;
+        for (int k = 0; k < taps_; k++) {
+            double x = k - (half - 1) - frac;
+            double sinc = (x == 0.0) ? 2.0 * cutoff : std::sin(2.0 * PI * cutoff * x) / (PI * x);
+            double h = sinc * blackman(x / half);
+            row[k] = static_cast<float>(h);
+            sum += h;
+        }
+        // DC gain = 1 ở mọi phase
+        for (int k = 0; k < taps_; k++) {
+            row[k] = static_cast<float>(row[k] / sum);
+        }
+    }
+
+    set_rate_ratio(1.0);
+    reset();
+}
+
+void Resampler::set_rate_ratio(double ratio) {
+    step_ = input_rate_ / (output_rate_ * ratio);
+}
+
+void Resampler::reset() {
+    // (half - 1) sample 0 phía trước: output đầu tiên rơi đúng vào input đầu tiên
+    history_.assign(taps_ / 2 - 1, 0.0f);
+    history_.reserve(4096);
+    position_ = 0.0;
+}
+
+void Resampler::process(const float* in, size_t count, std::vector<float>& out) {
+    if (taps_ == 0) {
+        out.insert(out.end(), in, in + count);
+        return;
+    }
+
+    history_.insert(history_.end(), in, in + count);
+    size_t available = history_.size();
+
+    while (static_cast<size_t>(position_) + taps_ <= available) {
+        size_t index = static_cast<size_t>(position_);
+        int phase = static_cast<int>((position_ - index) * phases_ + 0.5);
+
+        const float* h = &bank_[static_cast<size_t>(phase) * taps_];
+        const float* x = &history_[index];
+
+        // 8 accumulator độc lập: không phụ thuộc thứ tự cộng nên vector hoá được
+        // mà không cần -ffast-math
+        float acc[LANES] = {};
+        for (int i = 0; i < taps_; i += LANES) {
+            for (int lane = 0; lane < LANES; lane++) {
+                acc[lane] += h[i + lane] * x[i + lane];
+            }
+        }
+        out.push_back(((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7])));
+
+        position_ += step_;
+    }
+
+    // Bỏ phần input đã đi qua, giữ lại cửa sổ cho block sau
+    size_t consumed = std::min(static_cast<size_t>(position_), available);
+    history_.erase(history_.begin(), history_.begin() + consumed);
+    position_ -= consumed;
+}
+
+} // namespace nes
@@ -0,0 +1,72 @@
+#ifndef NES_RESAMPLER_H
+#define NES_RESAMPLER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace nes {
+
+/**
+ * @brief Resampler polyphase windowed-sinc (mono float)
+ *
+ * Chuyển buffer ở native rate của APU sang output rate của sound card, chạy
+ * một lần mỗi frame. Bộ lọc là sinc cửa sổ Blackman, cắt dưới Nyquist của
+ * rate thấp hơn, tính sẵn cho PHASES vị trí lẻ giữa 2 sample (polyphase).
+ * Mỗi output sample là một tích vô hướng TAPS phần tử trên 2 mảng liền nhau,
+ * cộng theo 8 lane độc lập nên compiler vector hoá được (SSE/AVX/NEON).
+ */
+class Resampler {
+public:
+    /**
+     * @brief Quality / speed: số taps và số phase của filter bank
+     */
+    enum Quality {
+        QUALITY_FAST,    // 8 taps, 64 phases
+        QUALITY_MEDIUM,  // 16 taps, 256 phases
+        QUALITY_BEST     // 32 taps, 1024 phases
+    };
+
+    Resampler();
+
+    /**
+     * @brief Dựng lại filter bank (xoá history)
+     */
+    void configure(double input_rate, double output_rate, Quality quality);
+
+    /**
+     * @brief Chỉnh nhẹ tỉ lệ (dynamic rate control), không dựng lại filter
+     * @param ratio 1.0 = đúng output rate, 1.005 = sinh nhiều hơn 0.5%
+     */
+    void set_rate_ratio(double ratio);
+
+    /**
+     * @brief Resample count samples, nối kết quả vào out
+     * Samples chưa đủ taps phía sau được giữ lại cho lần gọi sau.
+     */
+    void process(const float* in, size_t count, std::vector<float>& out);
+
+    void reset();
+
+    double get_input_rate() const { return input_rate_; }
+    double get_output_rate() const { return output_rate_; }
+    Quality get_quality() const { return quality_; }
+
+private:
+    static constexpr int LANES = 8;
+
+    double input_rate_;
+    double output_rate_;
+    Quality quality_;
+
+    int taps_;            // Bội số của LANES
+    int phases_;
+    std::vector<float> bank_;  // phases_ + 1 hàng x taps_ (hàng cuối = phase 0 dịch 1 sample)
+
+    double step_;         // Input samples mỗi output sample
+    double position_;     // Vị trí output kế tiếp trong history_ (input samples)
+    std::vector<float> history_;  // Input chưa dùng hết + block mới
+};
+
+} // namespace nes
+
+#endif // NES_RESAMPLER_H
@@ -1,6 +1,7 @@
 #include "cartridge/cartridge.h"
+#include "cartridge/rom_image.h"
 #include "mappers/mapper.h"
-#include <fstream>
+#include <algorithm>
 #include <iostream>
 
 // Include mapper headers
@@ -14,8 +15,11 @@
 namespace nes {
 
 Cartridge::Cartridge() 
-    : mapper_(nullptr), mapper_number_(0), has_battery_(false), 
-      mirror_mode_(MirrorMode::HORIZONTAL) {
+    : prg_rom_(nullptr), prg_size_(0), chr_rom_(nullptr), chr_size_(0),
+      mapper_(nullptr), mapper_number_(0), has_battery_(false), 
+      mirror_mode_(MirrorMode::HORIZONTAL), mirroring_(MirrorMode::HORIZONTAL),
+      irq_line_(false), watches_a12_(false) {
+    update_banks();
 }
 
 Cartridge::~Cartridge() {
@@ -23,24 +27,21 @@ Cartridge::~Cartridge() {
 }
 
 bool Cartridge::load_from_file(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Không thể mở ROM file: " << filename << std::endl;
+    std::shared_ptr<const RomImage> image = RomImage::open(filename);
+    if (!image) {
+        std::cerr << "Không thể mở ROM file hoặc file không phải iNES format: " << filename << std::endl;
         return false;
     }
-    
-    // Đọc iNES header (16 bytes)
-    uint8_t header[16];
-    file.read(reinterpret_cast<char*>(header), 16);
-    
-    // Kiểm tra magic number "NES\x1A"
-    if (header[0] != 'N' || header[1] != 'E' || 
-        header[2] != 'S' || header[3] != 0x1A) {
-        std::cerr << "File không phải iNES format!" << std::endl;
+    return load_from_image(std::move(image));
+}
+
+bool Cartridge::load_from_image(std::shared_ptr<const RomImage> image) {
+    if (!image) {
         return false;
     }
     
     // Parse header
+    const uint8_t* header = image->header();
     uint8_t prg_rom_size = header[4];  // Số blocks 16KB
     uint8_t chr_rom_size = header[5];  // Số blocks 8KB
     uint8_t flags6 = header[6];
@@ -82,25 +83,24 @@ bool Cartridge::load_from_file(const std::string& filename) {
     }
     std::cout << std::endl;
     
-    // Skip trainer nếu có (512 bytes)
-    if (has_trainer) {
-        file.seekg(512, std::ios::cur);
-    }
+    // Mapper cũ trỏ vào image / CHR RAM cũ: xoá trước khi thay
+    delete mapper_;
+    mapper_ = nullptr;
     
-    // Đọc PRG ROM
-    size_t prg_size = prg_rom_size * 16384;  // 16KB per block
-    prg_rom_.resize(prg_size);
-    file.read(reinterpret_cast<char*>(prg_rom_.data()), prg_size);
+    // PRG / CHR ROM trỏ thẳng vào image dùng chung (không copy)
+    image_ = std::move(image);
+    prg_rom_ = image_->prg();
+    prg_size_ = image_->prg_size();
     
-    // Đọc CHR ROM
-    size_t chr_size = chr_rom_size * 8192;  // 8KB per block
-    if (chr_size > 0) {
-        chr_rom_.resize(chr_size);
-        file.read(reinterpret_cast<char*>(chr_rom_.data()), chr_size);
+    if (image_->chr_size() > 0) {
+        chr_ram_.clear();
+        chr_rom_ = image_->chr();
+        chr_size_ = image_->chr_size();
     } else {
-        // CHR RAM (8KB)
-        chr_rom_.resize(8192);
-        std::fill(chr_rom_.begin(), chr_rom_.end(), 0);
+        // CHR RAM (8KB), riêng cho từng instance
+        chr_ram_.assign(8192, 0);
+        chr_rom_ = chr_ram_.data();
+        chr_size_ = chr_ram_.size();
     }
     
     // PRG RAM
@@ -108,18 +108,22 @@ bool Cartridge::load_from_file(const std::string& filename) {
     prg_ram_.resize(prg_ram_size * 8192);
     std::fill(prg_ram_.begin(), prg_ram_.end(), 0);
     
-    file.close();
-    
     // Tạo mapper
-    delete mapper_;
     mapper_ = create_mapper();
     
+    irq_line_ = false;
+    watches_a12_ = false;
+    update_banks();
+    
     if (!mapper_) {
         std::cerr << "Mapper " << (int)mapper_number_ 
                   << " chưa được implement!" << std::endl;
         return false;
     }
     
+    watches_a12_ = mapper_->uses_a12();
+    update_mirroring();
+    
     std::cout << "ROM loaded successfully!" << std::endl;
     return true;
 }
@@ -128,33 +132,33 @@ Mapper* Cartridge::create_mapper() {
     switch (mapper_number_) {
         case 0:
             // Mapper 0 (NROM)
-            return new Mapper0(prg_rom_.data(), prg_rom_.size(),
-                              chr_rom_.data(), chr_rom_.size());
+            return new Mapper0(prg_rom_, prg_size_,
+                              chr_rom_, chr_size_);
         
         case 1:
             // Mapper 1 (MMC1) - Zelda, Metroid, Mega Man 2, etc.
-            return new Mapper1(prg_rom_.data(), prg_rom_.size(),
-                              chr_rom_.data(), chr_rom_.size());
+            return new Mapper1(prg_rom_, prg_size_,
+                              chr_rom_, chr_size_);
         
         case 2:
             // Mapper 2 (UxROM) - Mega Man 1, Castlevania, Duck Tales, etc.
-            return new Mapper2(prg_rom_.data(), prg_rom_.size(),
-                              chr_rom_.data(), chr_rom_.size());
+            return new Mapper2(prg_rom_, prg_size_,
+                              chr_rom_, chr_size_);
         
         case 3:
             // Mapper 3 (CNROM) - Solomon's Key, Arkanoid, Paperboy, etc.
-            return new Mapper3(prg_rom_.data(), prg_rom_.size(),
-                              chr_rom_.data(), chr_rom_.size());
+            return new Mapper3(prg_rom_, prg_size_,
+                              chr_rom_, chr_size_);
         
         case 4:
             // Mapper 4 (MMC3) - Contra, Mega Man 3-6, SMB 2/3, etc.
-            return new Mapper4(prg_rom_.data(), prg_rom_.size(),
-                              chr_rom_.data(), chr_rom_.size());
+            return new Mapper4(prg_rom_, prg_size_,
+                              chr_rom_, chr_size_);
         
         case 7:
             // Mapper 7 (AxROM) - Battletoads, Wizards & Warriors, etc.
-            return new Mapper7(prg_rom_.data(), prg_rom_.size(),
-                              chr_rom_.data(), chr_rom_.size());
+            return new Mapper7(prg_rom_, prg_size_,
+                              chr_rom_, chr_size_);
         
         default:
             return nullptr;
@@ -170,11 +174,11 @@ uint8_t Cartridge::read(uint16_t address) {
     if (address >= 0x8000) {
         // PRG ROM
         uint16_t index = address - 0x8000;
-        if (prg_rom_.size() == 16384) {
+        if (prg_size_ == 16384) {
             // 16KB: Mirror
             index %= 16384;
         }
-        return prg_rom_[index];
+        return index < prg_size_ ? prg_rom_[index] : 0;
     }
     
     return 0;
@@ -183,6 +187,9 @@ uint8_t Cartridge::read(uint16_t address) {
 void Cartridge::write(uint16_t address, uint8_t value) {
     if (mapper_) {
         mapper_->write(address, value);
+        irq_line_ = mapper_->irq_pending();
+        update_mirroring();
+        if (address >= 0x8000) update_banks();
     }
     
     // PRG RAM ($6000-$7FFF)
@@ -194,21 +201,53 @@ void Cartridge::write(uint16_t address, uint8_t value) {
 void Cartridge::reset() {
     if (mapper_) {
         mapper_->reset();
+        irq_line_ = mapper_->irq_pending();
+        update_mirroring();
+        update_banks();
     }
 }
 
-MirrorMode Cartridge::get_mirroring() const {
-    // Some mappers (like MMC1) can change mirroring dynamically
+void Cartridge::notify_a12_rise() {
     if (mapper_) {
+        mapper_->notify_a12_rise();
+        irq_line_ = mapper_->irq_pending();
+    }
+}
+
+void Cartridge::update_mirroring() {
+    // Default: use mirroring from iNES header
+    MirrorMode mode = mirror_mode_;
+    
+    // Some mappers (like MMC1) can change mirroring dynamically.
+    // Four-screen (header flags6 bit 3) is hardwired VRAM on the board: the mapper's
+    // mirroring register has no effect (e.g. MMC3 in Gauntlet / Rad Racer II)
+    if (mapper_ && mirror_mode_ != MirrorMode::FOUR_SCREEN) {
         MirrorMode mapper_mirror = mapper_->get_mirroring();
         // If mapper returns HORIZONTAL (0), use cartridge's static mirroring
         // Otherwise, use mapper's dynamic mirroring
         if (static_cast<int>(mapper_mirror) != 0) {
-            return mapper_mirror;
+            mode = mapper_mirror;
         }
     }
-    // Default: use mirroring from iNES header
-    return mirror_mode_;
+    
+    if (mode != mirroring_) {
+        mirroring_ = mode;
+        if (mirroring_listener_) mirroring_listener_(mirroring_);
+    }
+}
+
+void Cartridge::set_mirroring_listener(std::function<void(MirrorMode)> listener) {
+    mirroring_listener_ = std::move(listener);
+    if (mirroring_listener_) mirroring_listener_(mirroring_);
+}
+
+void Cartridge::update_banks() {
+    for (int i = 0; i < 4; i++) {
+        prg_banks_[i] = mapper_ ? mapper_->get_prg_offset(0x8000 + i * 0x2000) : -1;
+    }
+    for (int i = 0; i < 8; i++) {
+        chr_banks_[i] = mapper_ ? mapper_->get_chr_offset(i * 0x400) : -1;
+    }
 }
 
 } // namespace nes
@@ -2,12 +2,15 @@
 #define NES_CARTRIDGE_H
 
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <string>
 
 namespace nes {
 
 class Mapper;
+class RomImage;
 
 /**
  * @brief Nametable mirroring modes
@@ -32,6 +35,16 @@ public:
      */
     bool load_from_file(const std::string& filename);
     
+    /**
+     * @brief Load từ image đã mở (nhiều Cartridge dùng chung một image)
+     */
+    bool load_from_image(std::shared_ptr<const RomImage> image);
+    
+    /**
+     * @brief Image đang dùng (nullptr nếu chưa load)
+     */
+    const std::shared_ptr<const RomImage>& get_rom_image() const { return image_; }
+    
     /**
      * @brief Đọc từ cartridge space
      */
@@ -49,23 +62,96 @@ public:
     
     /**
      * @brief Get nametable mirroring mode
-     * Some mappers (like MMC1) can change mirroring dynamically
+     * Some mappers (like MMC1) can change mirroring dynamically.
+     * Giá trị được cache, cập nhật sau mỗi lần ghi register mapper.
+     */
+    MirrorMode get_mirroring() const { return mirroring_; }
+    
+    /**
+     * @brief Đăng ký hàm được gọi khi mirroring thay đổi (load ROM, reset, ghi mapper)
+     * PPU dùng để cập nhật bảng trang nametable thay vì hỏi mirroring mỗi lần fetch.
+     * Được gọi ngay một lần khi đăng ký.
+     */
+    void set_mirroring_listener(std::function<void(MirrorMode)> listener);
+    
+    /**
+     * @brief PRG ROM offset đang được map tại địa chỉ CPU ($8000-$FFFF)
+     * Tra bảng bank đã cache (CDL gọi mỗi instruction / mỗi pattern fetch).
+     * @return -1 nếu địa chỉ không thuộc PRG ROM
+     */
+    int32_t get_prg_offset(uint16_t address) const {
+        if (address < 0x8000) return -1;
+        int32_t base = prg_banks_[(address >> 13) & 0x03];
+        return base < 0 ? -1 : base + (address & 0x1FFF);
+    }
+    
+    /**
+     * @brief CHR offset đang được map tại địa chỉ PPU ($0000-$1FFF)
+     * @return -1 nếu không có CHR
+     */
+    int32_t get_chr_offset(uint16_t address) const {
+        if (address >= 0x2000) return -1;
+        int32_t base = chr_banks_[address >> 10];
+        return base < 0 ? -1 : base + (address & 0x03FF);
+    }
+    
+    /**
+     * @brief IRQ line của cartridge (mapper IRQ), CPU poll mỗi instruction
+     * Được cập nhật sau mỗi lần ghi register mapper / A12 edge
+     */
+    const bool* get_irq_line() const { return &irq_line_; }
+    
+    /**
+     * @brief Mapper có đếm A12 rising edge không (MMC3)
+     */
+    bool watches_a12() const { return watches_a12_; }
+    
+    /**
+     * @brief PPU báo A12 rising edge (pattern fetch chuyển từ $0xxx sang $1xxx)
      */
-    MirrorMode get_mirroring() const;
+    void notify_a12_rise();
+    
+    size_t get_prg_size() const { return prg_size_; }
+    size_t get_chr_size() const { return chr_size_; }
+    
+    /**
+     * @brief Dữ liệu PRG ROM gốc (cho disassembler / profiler report / OAM DMA)
+     */
+    const uint8_t* get_prg_rom() const { return prg_rom_; }
 
 private:
-    std::vector<uint8_t> prg_rom_;  // Program ROM
-    std::vector<uint8_t> chr_rom_;  // Character ROM
+    std::shared_ptr<const RomImage> image_;  // File .nes bất biến, dùng chung
+    const uint8_t* prg_rom_;        // Program ROM (trong image_)
+    size_t prg_size_;
+    const uint8_t* chr_rom_;        // Character ROM (trong image_) hoặc chr_ram_
+    size_t chr_size_;
+    std::vector<uint8_t> chr_ram_;  // CHR RAM 8KB khi ROM không có CHR (riêng từng instance)
     std::vector<uint8_t> prg_ram_;  // Program RAM (battery-backed)
     
     Mapper* mapper_;
     
     uint8_t mapper_number_;
     bool has_battery_;
-    MirrorMode mirror_mode_;  // Nametable mirroring mode
+    MirrorMode mirror_mode_;  // Nametable mirroring mode (iNES header)
+    MirrorMode mirroring_;    // Mirroring đang dùng (header hoặc mapper)
+    std::function<void(MirrorMode)> mirroring_listener_;
+    
+    // Mapper IRQ
+    bool irq_line_;
+    bool watches_a12_;
+    
+    // Offset đầu của từng cửa sổ, -1 = không map. Mapper hỗ trợ bank PRG >= 8KB, CHR >= 1KB
+    int32_t prg_banks_[4];  // $8000, $A000, $C000, $E000
+    int32_t chr_banks_[8];  // $0000-$1FFF, mỗi cửa sổ 1KB
     
     // Helper để tạo mapper phù hợp
     Mapper* create_mapper();
+    
+    // Đọc lại mirroring từ mapper, báo listener nếu thay đổi
+    void update_mirroring();
+    
+    // Đọc lại bảng bank từ mapper (sau load / reset / ghi register)
+    void update_banks();
 };
 
 } // namespace nes
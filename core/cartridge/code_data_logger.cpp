@@ -0,0 +1,71 @@
+#include "cartridge/code_data_logger.h"
+#include <algorithm>
+#include <fstream>
+
+namespace nes {
+
+CodeDataLogger::CodeDataLogger() {
+}
+
+void CodeDataLogger::reset(size_t prg_size, size_t chr_size) {
+    prg_flags_.assign(prg_size, 0);
+    prg_exec_.assign(prg_size, 0);
+    chr_flags_.assign(chr_size, 0);
+}
+
+void CodeDataLogger::clear() {
+    std::fill(prg_flags_.begin(), prg_flags_.end(), 0);
+    std::fill(prg_exec_.begin(), prg_exec_.end(), 0);
+    std::fill(chr_flags_.begin(), chr_flags_.end(), 0);
+}
+
+bool CodeDataLogger::load(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(file.tellg());
+    if (size != prg_flags_.size() + chr_flags_.size()) {
+        return false;  // File của ROM khác
+    }
+    file.seekg(0);
+
+    std::vector<uint8_t> data(size);
+    file.read(reinterpret_cast<char*>(data.data()), size);
+    if (!file) {
+        return false;
+    }
+
+    for (size_t i = 0; i < prg_flags_.size(); i++) {
+        prg_flags_[i] |= data[i];
+    }
+    for (size_t i = 0; i < chr_flags_.size(); i++) {
+        chr_flags_[i] |= data[prg_flags_.size() + i];
+    }
+    return true;
+}
+
+bool CodeDataLogger::save(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(prg_flags_.data()), prg_flags_.size());
+    file.write(reinterpret_cast<const char*>(chr_flags_.data()), chr_flags_.size());
+    return static_cast<bool>(file);
+}
+
+void CodeDataLogger::get_prg_stats(size_t& code, size_t& data, size_t& unused) const {
+    code = 0;
+    data = 0;
+    unused = 0;
+    for (uint8_t flags : prg_flags_) {
+        if (flags & CDL_PRG_CODE) code++;
+        if (flags & CDL_PRG_DATA) data++;
+        if (flags == 0) unused++;
+    }
+}
+
+} // namespace nes
@@ -0,0 +1,112 @@
+#ifndef NES_CODE_DATA_LOGGER_H
+#define NES_CODE_DATA_LOGGER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nes {
+
+// PRG ROM flags (1 byte cho mỗi byte PRG, bit giống FCEUX)
+static constexpr uint8_t CDL_PRG_CODE          = 0x01;  // Được thực thi (opcode hoặc operand)
+static constexpr uint8_t CDL_PRG_DATA          = 0x02;  // Được đọc như dữ liệu
+static constexpr uint8_t CDL_PRG_BANK_MASK     = 0x0C;  // Cửa sổ CPU lúc truy cập: 0 = $8000, 1 = $A000, 2 = $C000, 3 = $E000
+static constexpr uint8_t CDL_PRG_INDIRECT_CODE = 0x10;  // Đích của JMP (ind)
+static constexpr uint8_t CDL_PRG_INDIRECT_DATA = 0x20;  // Đọc qua con trỏ ((zp,X), (zp),Y)
+
+// Vai trò của byte code trong lệnh (bitmap riêng, không ghi vào .cdl vì FCEUX không có).
+// Một byte vừa là opcode vừa là operand = có lệnh chồng lên nhau / disassembly sai
+static constexpr uint8_t CDL_EXEC_OPCODE  = 0x01;  // Byte đầu của một lệnh
+static constexpr uint8_t CDL_EXEC_OPERAND = 0x02;  // Operand của một lệnh
+
+// CHR flags (1 byte cho mỗi byte CHR)
+static constexpr uint8_t CDL_CHR_RENDERED = 0x01;  // PPU fetch khi render
+static constexpr uint8_t CDL_CHR_READ     = 0x02;  // CPU đọc qua $2007
+
+/**
+ * @brief Bits 2-3 của PRG flag: cửa sổ 8KB ($8000-$FFFF) chứa address
+ */
+inline uint8_t cdl_prg_bank_bits(uint16_t address) {
+    return static_cast<uint8_t>((address & 0x6000) >> 11);
+}
+
+/**
+ * @brief Code/Data Logger cho PRG ROM và CHR
+ *
+ * Đánh dấu từng byte ROM đã được dùng như thế nào trong lúc chạy game.
+ * Các hàm log_* chỉ là một phép OR nên có thể bật trong lúc chơi bình thường.
+ * File .cdl = PRG flags nối tiếp CHR flags (cùng layout với FCEUX); opcode / operand
+ * chỉ giữ trong bộ nhớ (get_prg_exec_flags).
+ */
+class CodeDataLogger {
+public:
+    CodeDataLogger();
+
+    /**
+     * @brief Cấp phát lại bitmap (xoá hết) cho ROM mới
+     */
+    void reset(size_t prg_size, size_t chr_size);
+
+    /**
+     * @brief Xoá flags nhưng giữ kích thước
+     */
+    void clear();
+
+    /**
+     * @brief Load file .cdl (OR vào dữ liệu hiện có)
+     * @return false nếu không mở được hoặc kích thước không khớp ROM
+     */
+    bool load(const std::string& filename);
+
+    bool save(const std::string& filename) const;
+
+    /**
+     * @brief Đánh dấu một lệnh đã thực thi (opcode + operand bytes)
+     * @param prg_offset Offset trong PRG ROM (< 0 = không phải ROM, bỏ qua)
+     * @param address Địa chỉ CPU của opcode (cho bank bits)
+     */
+    void log_instruction(int32_t prg_offset, int length, uint16_t address) {
+        if (prg_offset < 0 || static_cast<size_t>(prg_offset) + length > prg_flags_.size()) {
+            return;
+        }
+        uint8_t* flags = &prg_flags_[prg_offset];
+        uint8_t* exec = &prg_exec_[prg_offset];
+        uint8_t value = CDL_PRG_CODE | cdl_prg_bank_bits(address);
+        flags[0] |= value;
+        exec[0] |= CDL_EXEC_OPCODE;
+        for (int i = 1; i < length; i++) {
+            flags[i] |= value;
+            exec[i] |= CDL_EXEC_OPERAND;
+        }
+    }
+
+    void log_prg(int32_t prg_offset, uint8_t flags, uint16_t address) {
+        if (prg_offset >= 0 && static_cast<size_t>(prg_offset) < prg_flags_.size()) {
+            prg_flags_[prg_offset] |= flags | cdl_prg_bank_bits(address);
+        }
+    }
+
+    void log_chr(int32_t chr_offset, uint8_t flags) {
+        if (chr_offset >= 0 && static_cast<size_t>(chr_offset) < chr_flags_.size()) {
+            chr_flags_[chr_offset] |= flags;
+        }
+    }
+
+    const std::vector<uint8_t>& get_prg_flags() const { return prg_flags_; }
+    const std::vector<uint8_t>& get_prg_exec_flags() const { return prg_exec_; }
+    const std::vector<uint8_t>& get_chr_flags() const { return chr_flags_; }
+
+    /**
+     * @brief Số byte PRG đã được đánh dấu code / data / chưa dùng
+     */
+    void get_prg_stats(size_t& code, size_t& data, size_t& unused) const;
+
+private:
+    std::vector<uint8_t> prg_flags_;
+    std::vector<uint8_t> prg_exec_;   // CDL_EXEC_* (chỉ từ phiên hiện tại, file .cdl không có)
+    std::vector<uint8_t> chr_flags_;
+};
+
+} // namespace nes
+
+#endif // NES_CODE_DATA_LOGGER_H
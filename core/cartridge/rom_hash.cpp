@@ -0,0 +1,184 @@
+#include "cartridge/rom_hash.h"
+#include <algorithm>
+#include <cstring>
+
+namespace nes {
+
+namespace {
+
+struct Crc32Tables {
+    uint32_t t[8][256];
+
+    Crc32Tables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            t[0][i] = c;
+        }
+        // t[k][i] = CRC của byte i theo sau bởi k bytes 0
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int k = 1; k < 8; k++) {
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+const Crc32Tables& crc_tables() {
+    static const Crc32Tables tables;
+    return tables;
+}
+
+inline uint32_t load_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint32_t load_be32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+inline uint32_t rotl(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+} // namespace
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc) {
+    const auto& t = crc_tables().t;
+    crc = ~crc;
+
+    while (size >= 8) {
+        uint32_t lo = load_le32(data) ^ crc;
+        uint32_t hi = load_le32(data + 4);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^
+              t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+              t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+    }
+    return ~crc;
+}
+
+Sha1::Sha1() : buffer_size_(0), total_size_(0) {
+    state_[0] = 0x67452301;
+    state_[1] = 0xEFCDAB89;
+    state_[2] = 0x98BADCFE;
+    state_[3] = 0x10325476;
+    state_[4] = 0xC3D2E1F0;
+}
+
+void Sha1::update(const uint8_t* data, size_t size) {
+    total_size_ += size;
+
+    if (buffer_size_ > 0) {
+        size_t take = std::min(size, sizeof(buffer_) - buffer_size_);
+        std::memcpy(buffer_ + buffer_size_, data, take);
+        buffer_size_ += take;
+        data += take;
+        size -= take;
+        if (buffer_size_ < sizeof(buffer_)) {
+            return;
+        }
+        process_block(buffer_);
+        buffer_size_ = 0;
+    }
+
+    // Block đầy đủ được xử lý thẳng từ input, không copy
+    while (size >= 64) {
+        process_block(data);
+        data += 64;
+        size -= 64;
+    }
+
+    std::memcpy(buffer_, data, size);
+    buffer_size_ = size;
+}
+
+void Sha1::finish(uint8_t digest[DIGEST_SIZE]) {
+    uint64_t bit_size = total_size_ * 8;
+
+    // Padding: 0x80, các byte 0, rồi độ dài (bits) big-endian ở 8 bytes cuối
+    uint8_t pad[72] = {0x80};
+    size_t pad_size = (buffer_size_ < 56) ? (56 - buffer_size_) : (120 - buffer_size_);
+    for (int i = 0; i < 8; i++) {
+        pad[pad_size + i] = static_cast<uint8_t>(bit_size >> (56 - i * 8));
+    }
+    update(pad, pad_size + 8);
+
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4 + 0] = static_cast<uint8_t>(state_[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(state_[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(state_[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(state_[i]);
+    }
+}
+
+void Sha1::hash(const uint8_t* data, size_t size, uint8_t digest[DIGEST_SIZE]) {
+    Sha1 sha;
+    sha.update(data, size);
+    sha.finish(digest);
+}
+
+std::string Sha1::to_hex(const uint8_t digest[DIGEST_SIZE]) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(DIGEST_SIZE * 2, '0');
+    for (size_t i = 0; i < DIGEST_SIZE; i++) {
+        hex[i * 2] = digits[digest[i] >> 4];
+        hex[i * 2 + 1] = digits[digest[i] & 0x0F];
+    }
+    return hex;
+}
+
+void Sha1::process_block(const uint8_t* block) {
+    // Message schedule dạng vòng 16 words thay vì mảng 80 words
+    uint32_t w[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = load_be32(block + i * 4);
+    }
+
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3], e = state_[4];
+
+    for (int i = 0; i < 80; i++) {
+        if (i >= 16) {
+            w[i & 15] = rotl(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15], 1);
+        }
+
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+
+        uint32_t temp = rotl(a, 5) + f + e + k + w[i & 15];
+        e = d;
+        d = c;
+        c = rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+}
+
+} // namespace nes
@@ -0,0 +1,56 @@
+#ifndef NES_ROM_HASH_H
+#define NES_ROM_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace nes {
+
+/**
+ * @brief CRC32 (IEEE 802.3, giống zlib / No-Intro), slice-by-8
+ *
+ * Xử lý 8 bytes mỗi vòng lặp qua 8 bảng 256 entries thay vì 1 byte / bảng
+ * như cách cổ điển, nhanh hơn ~4-5 lần trên ROM lớn.
+ * @param crc Giá trị trả về của lần gọi trước (0 cho lần đầu) để hash nhiều đoạn
+ */
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+/**
+ * @brief SHA-1 tăng dần (update nhiều lần rồi finish)
+ */
+class Sha1 {
+public:
+    static constexpr size_t DIGEST_SIZE = 20;
+
+    Sha1();
+
+    void update(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Kết thúc và ghi digest 20 bytes (object không dùng lại được sau đó)
+     */
+    void finish(uint8_t digest[DIGEST_SIZE]);
+
+    /**
+     * @brief Hash một lần cho cả buffer
+     */
+    static void hash(const uint8_t* data, size_t size, uint8_t digest[DIGEST_SIZE]);
+
+    /**
+     * @brief Digest dạng hex chữ thường (40 ký tự)
+     */
+    static std::string to_hex(const uint8_t digest[DIGEST_SIZE]);
+
+private:
+    void process_block(const uint8_t* block);
+
+    uint32_t state_[5];
+    uint8_t buffer_[64];
+    size_t buffer_size_;
+    uint64_t total_size_;
+};
+
+} // namespace nes
+
+#endif // NES_ROM_HASH_H
@@ -0,0 +1,155 @@
+#include "cartridge/rom_image.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NES_ROM_IMAGE_MMAP 1
+#endif
+
+namespace fs = std::filesystem;
+
+namespace nes {
+
+namespace {
+
+// Image đang được dùng, theo path. weak_ptr: image tự giải phóng khi Cartridge
+// cuối cùng thả nó, registry chỉ giữ entry hết hạn cho tới lần open sau.
+struct ImageRegistry {
+    struct Entry {
+        uint64_t size;
+        int64_t mtime;
+        std::weak_ptr<const RomImage> image;
+    };
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+};
+
+ImageRegistry& registry() {
+    static ImageRegistry instance;
+    return instance;
+}
+
+size_t required_size(const uint8_t* header) {
+    size_t size = RomImage::HEADER_SIZE + header[4] * 16384 + header[5] * 8192;
+    if (header[6] & 0x04) {
+        size += RomImage::TRAINER_SIZE;
+    }
+    return size;
+}
+
+} // namespace
+
+RomImage::RomImage()
+    : data_(nullptr), size_(0), mapped_size_(0),
+      prg_(nullptr), prg_size_(0), chr_(nullptr), chr_size_(0) {
+}
+
+RomImage::~RomImage() {
+#ifdef NES_ROM_IMAGE_MMAP
+    if (mapped_size_) {
+        munmap(const_cast<uint8_t*>(data_), mapped_size_);
+    }
+#endif
+}
+
+std::shared_ptr<const RomImage> RomImage::open(const std::string& filename) {
+    std::error_code ec;
+    std::string key = fs::absolute(filename, ec).lexically_normal().string();
+    if (ec) {
+        key = filename;
+    }
+    uint64_t file_size = fs::file_size(filename, ec);
+    if (ec) {
+        return nullptr;
+    }
+    int64_t mtime = static_cast<int64_t>(fs::last_write_time(filename, ec).time_since_epoch().count());
+
+    // Lock giữ trong lúc map/đọc để 2 instance mở cùng lúc không tạo 2 image
+    ImageRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto it = reg.entries.find(key);
+    if (it != reg.entries.end() && it->second.size == file_size && it->second.mtime == mtime) {
+        if (auto shared = it->second.image.lock()) {
+            return shared;
+        }
+    }
+
+    if (file_size < HEADER_SIZE) {
+        return nullptr;
+    }
+    std::shared_ptr<RomImage> image(new RomImage());
+
+#ifdef NES_ROM_IMAGE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        void* addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // Mapping vẫn giữ sau khi đóng fd
+        if (addr != MAP_FAILED) {
+            image->data_ = static_cast<const uint8_t*>(addr);
+            image->size_ = file_size;
+            image->mapped_size_ = file_size;
+        }
+    }
+#endif
+
+    // File ngắn hơn header khai báo: copy ra buffer đủ dài (phần thiếu = 0),
+    // giống cách đọc cũ với vector đã resize
+    if (image->data_ && image->size_ < required_size(image->data_)) {
+        image->owned_.assign(required_size(image->data_), 0);
+        std::copy(image->data_, image->data_ + image->size_, image->owned_.begin());
+#ifdef NES_ROM_IMAGE_MMAP
+        munmap(const_cast<uint8_t*>(image->data_), image->mapped_size_);
+#endif
+        image->mapped_size_ = 0;
+        image->data_ = image->owned_.data();
+        image->size_ = image->owned_.size();
+    }
+
+    if (!image->data_) {
+        // Fallback: đọc cả file
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            return nullptr;
+        }
+        image->owned_.resize(file_size);
+        file.read(reinterpret_cast<char*>(image->owned_.data()), file_size);
+        if (image->owned_.size() < required_size(image->owned_.data())) {
+            image->owned_.resize(required_size(image->owned_.data()), 0);
+        }
+        image->data_ = image->owned_.data();
+        image->size_ = image->owned_.size();
+    }
+
+    if (!image->parse()) {
+        return nullptr;
+    }
+
+    reg.entries[key] = {file_size, mtime, image};
+    return image;
+}
+
+bool RomImage::parse() {
+    const uint8_t* h = data_;
+    if (h[0] != 'N' || h[1] != 'E' || h[2] != 'S' || h[3] != 0x1A) {
+        return false;
+    }
+
+    const uint8_t* p = data_ + HEADER_SIZE;
+    if (h[6] & 0x04) {
+        p += TRAINER_SIZE;  // Trainer không được dùng
+    }
+    prg_ = p;
+    prg_size_ = h[4] * 16384;
+    chr_ = p + prg_size_;
+    chr_size_ = h[5] * 8192;
+    return true;
+}
+
+} // namespace nes
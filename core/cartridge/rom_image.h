@@ -0,0 +1,72 @@
+#ifndef NES_ROM_IMAGE_H
+#define NES_ROM_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nes {
+
+/**
+ * @brief Nội dung file .nes bất biến, dùng chung giữa các Cartridge
+ *
+ * Trên Linux/macOS file được mmap (read-only, trang chỉ được nạp khi truy cập),
+ * các hệ khác đọc một lần vào buffer. Mọi Cartridge / Mapper mở cùng file
+ * (cùng size + mtime) dùng chung một image qua shared_ptr, nên chạy nhiều
+ * instance emulator của cùng game không nhân bản PRG/CHR ROM.
+ * CHR RAM và PRG RAM không nằm ở đây, mỗi Cartridge có bản riêng.
+ */
+class RomImage {
+public:
+    static constexpr size_t HEADER_SIZE = 16;
+    static constexpr size_t TRAINER_SIZE = 512;
+
+    ~RomImage();
+
+    RomImage(const RomImage&) = delete;
+    RomImage& operator=(const RomImage&) = delete;
+
+    /**
+     * @brief Mở (hoặc lấy lại image đang được dùng) cho một file .nes
+     * @return nullptr nếu không mở được hoặc không phải iNES
+     */
+    static std::shared_ptr<const RomImage> open(const std::string& filename);
+
+    const uint8_t* header() const { return data_; }
+
+    const uint8_t* prg() const { return prg_; }
+    size_t prg_size() const { return prg_size_; }
+
+    /**
+     * @brief CHR ROM (chr_size() == 0 nếu cartridge dùng CHR RAM)
+     */
+    const uint8_t* chr() const { return chr_; }
+    size_t chr_size() const { return chr_size_; }
+
+    /**
+     * @brief true nếu dữ liệu được mmap thay vì đọc vào buffer
+     */
+    bool is_mapped() const { return mapped_size_ != 0; }
+
+private:
+    RomImage();
+
+    // Đặt con trỏ PRG/CHR theo header, false nếu header sai
+    bool parse();
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t mapped_size_;          // != 0: data_ là vùng mmap
+    std::vector<uint8_t> owned_;  // Fallback khi không mmap được / file bị cắt
+
+    const uint8_t* prg_;
+    size_t prg_size_;
+    const uint8_t* chr_;
+    size_t chr_size_;
+};
+
+} // namespace nes
+
+#endif // NES_ROM_IMAGE_H
@@ -0,0 +1,326 @@
+#include "cartridge/rom_library.h"
+#include "cartridge/rom_hash.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace nes {
+
+namespace {
+
+constexpr char INDEX_MAGIC[4] = {'N', 'E', 'S', 'L'};
+constexpr uint32_t INDEX_VERSION = 1;
+
+std::string normalize_path(const std::string& path) {
+    return fs::path(path).lexically_normal().string();
+}
+
+bool has_nes_extension(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".nes";
+}
+
+template <typename T>
+void write_pod(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_pod(std::ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+} // namespace
+
+uint64_t RomInfo::hash64() const {
+    uint64_t hash = 0;
+    for (int i = 0; i < 8; i++) {
+        hash = (hash << 8) | sha1[i];
+    }
+    return hash;
+}
+
+std::string RomInfo::title() const {
+    return fs::path(path).stem().string();
+}
+
+RomLibrary::RomLibrary() {
+}
+
+bool RomLibrary::load(const std::string& filename) {
+    entries_.clear();
+    rebuild_lookup();
+
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0, count = 0;
+    file.read(magic, 4);
+    if (!file || std::memcmp(magic, INDEX_MAGIC, 4) != 0 ||
+        !read_pod(file, version) || version != INDEX_VERSION || !read_pod(file, count)) {
+        return false;
+    }
+
+    std::vector<RomInfo> entries;
+    entries.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        RomInfo info;
+        uint16_t path_len = 0;
+        if (!read_pod(file, path_len)) {
+            return false;
+        }
+        info.path.resize(path_len);
+        file.read(&info.path[0], path_len);
+        bool ok = static_cast<bool>(file) &&
+                  read_pod(file, info.file_size) && read_pod(file, info.mtime) &&
+                  read_pod(file, info.crc32) && read_pod(file, info.sha1) &&
+                  read_pod(file, info.mapper) && read_pod(file, info.prg_banks) &&
+                  read_pod(file, info.chr_banks) && read_pod(file, info.flags);
+        if (!ok) {
+            return false;  // File bị cắt: bỏ cả index, lần scan sau hash lại
+        }
+        entries.push_back(std::move(info));
+    }
+
+    entries_ = std::move(entries);
+    rebuild_lookup();
+    return true;
+}
+
+bool RomLibrary::save(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.write(INDEX_MAGIC, 4);
+    write_pod(file, INDEX_VERSION);
+    write_pod(file, static_cast<uint32_t>(entries_.size()));
+    for (const RomInfo& info : entries_) {
+        uint16_t path_len = static_cast<uint16_t>(std::min<size_t>(info.path.size(), 0xFFFF));
+        write_pod(file, path_len);
+        file.write(info.path.data(), path_len);
+        write_pod(file, info.file_size);
+        write_pod(file, info.mtime);
+        write_pod(file, info.crc32);
+        write_pod(file, info.sha1);
+        write_pod(file, info.mapper);
+        write_pod(file, info.prg_banks);
+        write_pod(file, info.chr_banks);
+        write_pod(file, info.flags);
+    }
+    return static_cast<bool>(file);
+}
+
+size_t RomLibrary::scan(const std::vector<std::string>& folders, unsigned threads) {
+    std::vector<std::string> paths;
+    for (const std::string& folder : folders) {
+        std::error_code ec;
+        fs::recursive_directory_iterator it(folder, fs::directory_options::skip_permission_denied, ec);
+        for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && has_nes_extension(it->path())) {
+                paths.push_back(it->path().string());
+            }
+        }
+    }
+    return refresh(paths, threads);
+}
+
+size_t RomLibrary::update(const std::vector<std::string>& paths, unsigned threads) {
+    return refresh(paths, threads);
+}
+
+const RomInfo* RomLibrary::update(const std::string& path) {
+    refresh({path}, 1);
+    return find_by_path(path);
+}
+
+size_t RomLibrary::prune() {
+    size_t before = entries_.size();
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                  [](const RomInfo& info) {
+                                      std::error_code ec;
+                                      return !fs::is_regular_file(info.path, ec);
+                                  }),
+                   entries_.end());
+    rebuild_lookup();
+    return before - entries_.size();
+}
+
+const RomInfo* RomLibrary::find_by_path(const std::string& path) const {
+    auto it = by_path_.find(normalize_path(path));
+    return it != by_path_.end() ? &entries_[it->second] : nullptr;
+}
+
+const RomInfo* RomLibrary::find_by_crc32(uint32_t crc) const {
+    auto it = by_crc32_.find(crc);
+    return it != by_crc32_.end() ? &entries_[it->second] : nullptr;
+}
+
+const RomInfo* RomLibrary::find_by_sha1(const uint8_t sha1[20]) const {
+    // hash64 là prefix của SHA-1, chỉ cần so nốt 12 bytes còn lại
+    uint64_t prefix = 0;
+    for (int i = 0; i < 8; i++) {
+        prefix = (prefix << 8) | sha1[i];
+    }
+    const RomInfo* info = find_by_hash64(prefix);
+    return (info && std::memcmp(info->sha1, sha1, 20) == 0) ? info : nullptr;
+}
+
+const RomInfo* RomLibrary::find_by_hash64(uint64_t hash) const {
+    auto it = by_hash64_.find(hash);
+    return it != by_hash64_.end() ? &entries_[it->second] : nullptr;
+}
+
+bool RomLibrary::stat_file(const std::string& path, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    auto file_size = fs::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    auto time = fs::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    size = static_cast<uint64_t>(file_size);
+    mtime = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+bool RomLibrary::hash_file(const std::string& path, RomInfo& info) {
+    if (!stat_file(path, info.file_size, info.mtime)) {
+        return false;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    uint8_t header[16];
+    if (!file.read(reinterpret_cast<char*>(header), 16) ||
+        header[0] != 'N' || header[1] != 'E' || header[2] != 'S' || header[3] != 0x1A) {
+        return false;
+    }
+
+    info.path = normalize_path(path);
+    info.prg_banks = header[4];
+    info.chr_banks = header[5];
+    info.mapper = (header[7] & 0xF0) | (header[6] >> 4);
+    info.flags = 0;
+    if (header[6] & 0x01) info.flags |= RomInfo::FLAG_VERTICAL;
+    if (header[6] & 0x02) info.flags |= RomInfo::FLAG_BATTERY;
+    if (header[6] & 0x04) info.flags |= RomInfo::FLAG_TRAINER;
+    if (header[6] & 0x08) info.flags |= RomInfo::FLAG_FOUR_SCREEN;
+
+    if (info.flags & RomInfo::FLAG_TRAINER) {
+        file.seekg(512, std::ios::cur);
+    }
+
+    // Đọc theo từng khối, CRC32 và SHA-1 chạy cùng một lượt đọc
+    uint32_t crc = 0;
+    Sha1 sha;
+    std::vector<char> chunk(64 * 1024);
+    while (file) {
+        file.read(chunk.data(), chunk.size());
+        size_t got = static_cast<size_t>(file.gcount());
+        if (got == 0) {
+            break;
+        }
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(chunk.data());
+        crc = crc32(data, got, crc);
+        sha.update(data, got);
+    }
+    info.crc32 = crc;
+    sha.finish(info.sha1);
+    return true;
+}
+
+size_t RomLibrary::refresh(const std::vector<std::string>& paths, unsigned threads) {
+    // Chỉ hash file mới hoặc có size / mtime khác với index
+    std::vector<std::string> todo;
+    for (const std::string& raw : paths) {
+        std::string path = normalize_path(raw);
+        uint64_t size;
+        int64_t mtime;
+        if (!stat_file(path, size, mtime)) {
+            continue;
+        }
+        auto it = by_path_.find(path);
+        if (it != by_path_.end() &&
+            entries_[it->second].file_size == size && entries_[it->second].mtime == mtime) {
+            continue;
+        }
+        if (std::find(todo.begin(), todo.end(), path) == todo.end()) {
+            todo.push_back(path);
+        }
+    }
+    if (todo.empty()) {
+        return 0;
+    }
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, todo.size()));
+
+    std::vector<RomInfo> results(todo.size());
+    std::vector<uint8_t> ok(todo.size(), 0);
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < todo.size(); i = next++) {
+            ok[i] = hash_file(todo[i], results[i]) ? 1 : 0;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    for (size_t i = 0; i < todo.size(); i++) {
+        if (ok[i]) {
+            put(std::move(results[i]));
+        } else {
+            std::cerr << "ROM library: bỏ qua file không phải iNES: " << todo[i] << std::endl;
+        }
+    }
+    rebuild_lookup();
+    return todo.size();
+}
+
+void RomLibrary::put(RomInfo&& info) {
+    auto it = by_path_.find(info.path);
+    if (it != by_path_.end()) {
+        entries_[it->second] = std::move(info);
+    } else {
+        by_path_[info.path] = entries_.size();
+        entries_.push_back(std::move(info));
+    }
+}
+
+void RomLibrary::rebuild_lookup() {
+    by_path_.clear();
+    by_hash64_.clear();
+    by_crc32_.clear();
+    for (size_t i = 0; i < entries_.size(); i++) {
+        by_path_[entries_[i].path] = i;
+        // Nhiều bản copy cùng nội dung: giữ entry đầu tiên
+        by_hash64_.emplace(entries_[i].hash64(), i);
+        by_crc32_.emplace(entries_[i].crc32, i);
+    }
+}
+
+} // namespace nes
@@ -0,0 +1,123 @@
+#ifndef NES_ROM_LIBRARY_H
+#define NES_ROM_LIBRARY_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nes {
+
+/**
+ * @brief Thông tin một ROM trong library (định danh theo nội dung, không theo path)
+ */
+struct RomInfo {
+    static constexpr uint8_t FLAG_VERTICAL    = 0x01;
+    static constexpr uint8_t FLAG_BATTERY     = 0x02;
+    static constexpr uint8_t FLAG_TRAINER     = 0x04;
+    static constexpr uint8_t FLAG_FOUR_SCREEN = 0x08;
+
+    std::string path;
+    uint64_t file_size = 0;
+    int64_t mtime = 0;          // filesystem::last_write_time, đơn vị của clock hệ thống
+
+    // Hash trên PRG + CHR (bỏ header iNES và trainer), giống cách No-Intro tính,
+    // nên 2 file cùng game chỉ khác header vẫn cùng định danh
+    uint32_t crc32 = 0;
+    uint8_t sha1[20] = {};
+
+    uint8_t mapper = 0;
+    uint8_t prg_banks = 0;      // Số blocks 16KB
+    uint8_t chr_banks = 0;      // Số blocks 8KB (0 = CHR RAM)
+    uint8_t flags = 0;          // FLAG_*
+
+    /**
+     * @brief Hash 64-bit (8 bytes đầu của SHA-1), đủ để so khớp ROM qua mạng
+     */
+    uint64_t hash64() const;
+
+    /**
+     * @brief Tên hiển thị (tên file không có đuôi)
+     */
+    std::string title() const;
+};
+
+/**
+ * @brief Index các ROM theo nội dung (CRC32 + SHA-1), lưu ra file binary
+ *
+ * Scan thư mục chạy song song trên nhiều thread. Scan lại chỉ hash những file
+ * có size / mtime thay đổi so với index, còn lại dùng lại kết quả cũ.
+ * Không thread-safe: mọi hàm gọi từ một thread (scan tự chia việc bên trong).
+ */
+class RomLibrary {
+public:
+    RomLibrary();
+
+    /**
+     * @brief Load index đã lưu
+     * @return false nếu không có file hoặc file hỏng / khác version (index rỗng)
+     */
+    bool load(const std::string& filename);
+
+    bool save(const std::string& filename) const;
+
+    /**
+     * @brief Scan (đệ quy) các thư mục, thêm / cập nhật mọi file .nes tìm thấy
+     * @param threads Số worker (0 = theo hardware_concurrency)
+     * @return Số file phải hash lại (mới hoặc đã thay đổi)
+     */
+    size_t scan(const std::vector<std::string>& folders, unsigned threads = 0);
+
+    /**
+     * @brief Cập nhật index cho danh sách file cụ thể (song song, incremental)
+     * @return Số file phải hash lại
+     */
+    size_t update(const std::vector<std::string>& paths, unsigned threads = 0);
+
+    /**
+     * @brief Cập nhật một file và trả về entry của nó
+     * @return nullptr nếu file không tồn tại hoặc không phải iNES
+     */
+    const RomInfo* update(const std::string& path);
+
+    /**
+     * @brief Xoá các entry có file không còn tồn tại
+     * @return Số entry đã xoá
+     */
+    size_t prune();
+
+    // Con trỏ trả về hết hạn khi index thay đổi (scan / update / prune / load)
+    const RomInfo* find_by_path(const std::string& path) const;
+    const RomInfo* find_by_crc32(uint32_t crc) const;
+    const RomInfo* find_by_sha1(const uint8_t sha1[20]) const;
+    const RomInfo* find_by_hash64(uint64_t hash) const;
+
+    const std::vector<RomInfo>& entries() const { return entries_; }
+    size_t size() const { return entries_.size(); }
+
+    /**
+     * @brief Đọc header + hash nội dung một file ROM
+     * @return false nếu không đọc được hoặc không phải iNES
+     */
+    static bool hash_file(const std::string& path, RomInfo& info);
+
+    /**
+     * @brief Đọc size + mtime (rẻ, không mở file)
+     */
+    static bool stat_file(const std::string& path, uint64_t& size, int64_t& mtime);
+
+private:
+    // Hash song song các file cần hash, rồi ghi kết quả vào index (thread gọi)
+    size_t refresh(const std::vector<std::string>& paths, unsigned threads);
+    void put(RomInfo&& info);
+    void rebuild_lookup();
+
+    std::vector<RomInfo> entries_;
+    std::unordered_map<std::string, size_t> by_path_;
+    std::unordered_map<uint64_t, size_t> by_hash64_;
+    std::unordered_map<uint32_t, size_t> by_crc32_;
+};
+
+} // namespace nes
+
+#endif // NES_ROM_LIBRARY_H
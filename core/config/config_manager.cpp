@@ -5,6 +5,7 @@
 #include <random>
 #include <iomanip>
 #include <filesystem>
+#include <cstdlib>
 
 namespace nes {
 
@@ -69,6 +70,11 @@ void ConfigManager::save() {
         file << "nickname=" << nickname_ << "\n";
         file << "avatar_path=" << avatar_path_ << "\n";
         file << "gameplay_recorder_enabled=" << (gameplay_recorder_enabled_ ? "1" : "0") << "\n";
+        file << "code_data_logger_enabled=" << (code_data_logger_enabled_ ? "1" : "0") << "\n";
+        file << "frame_skip_enabled=" << (frame_skip_enabled_ ? "1" : "0") << "\n";
+        file << "sprite_limit_enabled=" << (sprite_limit_enabled_ ? "1" : "0") << "\n";
+        file << "audio_sample_rate=" << audio_sample_rate_ << "\n";
+        file << "audio_quality=" << audio_quality_ << "\n";
         std::cout << "[Config] Saved to " << config_file_ << ": " << nickname_ << ", " << avatar_path_ << ", Recorder: " << gameplay_recorder_enabled_ << std::endl;
     } else {
         std::cerr << "[Config] Failed to open file for writing: " << config_file_ << std::endl;
@@ -93,6 +99,11 @@ void ConfigManager::parse_line(const std::string& line) {
         else if (key == "nickname") nickname_ = value;
         else if (key == "avatar_path") avatar_path_ = value;
         else if (key == "gameplay_recorder_enabled") gameplay_recorder_enabled_ = (value == "1" || value == "true");
+        else if (key == "code_data_logger_enabled") code_data_logger_enabled_ = (value == "1" || value == "true");
+        else if (key == "frame_skip_enabled") frame_skip_enabled_ = (value == "1" || value == "true");
+        else if (key == "sprite_limit_enabled") sprite_limit_enabled_ = (value == "1" || value == "true");
+        else if (key == "audio_sample_rate") set_audio_sample_rate(std::atoi(value.c_str()));
+        else if (key == "audio_quality") set_audio_quality(std::atoi(value.c_str()));
     }
 }
 
@@ -115,11 +126,25 @@ std::string ConfigManager::get_device_id() const { return device_id_; }
 std::string ConfigManager::get_nickname() const { return nickname_; }
 std::string ConfigManager::get_avatar_path() const { return avatar_path_; }
 bool ConfigManager::get_gameplay_recorder_enabled() const { return gameplay_recorder_enabled_; }
+bool ConfigManager::get_code_data_logger_enabled() const { return code_data_logger_enabled_; }
+bool ConfigManager::get_frame_skip_enabled() const { return frame_skip_enabled_; }
+bool ConfigManager::get_sprite_limit_enabled() const { return sprite_limit_enabled_; }
+int ConfigManager::get_audio_sample_rate() const { return audio_sample_rate_; }
+int ConfigManager::get_audio_quality() const { return audio_quality_; }
 
 // Setters
 void ConfigManager::set_device_id(const std::string& value) { device_id_ = value; }
 void ConfigManager::set_nickname(const std::string& value) { nickname_ = value; }
 void ConfigManager::set_avatar_path(const std::string& value) { avatar_path_ = value; }
 void ConfigManager::set_gameplay_recorder_enabled(bool value) { gameplay_recorder_enabled_ = value; }
+void ConfigManager::set_code_data_logger_enabled(bool value) { code_data_logger_enabled_ = value; }
+void ConfigManager::set_frame_skip_enabled(bool value) { frame_skip_enabled_ = value; }
+void ConfigManager::set_sprite_limit_enabled(bool value) { sprite_limit_enabled_ = value; }
+void ConfigManager::set_audio_sample_rate(int value) {
+    if (value >= 8000 && value <= 192000) audio_sample_rate_ = value;
+}
+void ConfigManager::set_audio_quality(int value) {
+    if (value >= 0 && value <= 2) audio_quality_ = value;
+}
 
 }
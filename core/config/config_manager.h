@@ -22,12 +22,22 @@ public:
     std::string get_nickname() const;
     std::string get_avatar_path() const;
     bool get_gameplay_recorder_enabled() const;
+    bool get_code_data_logger_enabled() const;
+    bool get_frame_skip_enabled() const;
+    bool get_sprite_limit_enabled() const;
+    int get_audio_sample_rate() const;
+    int get_audio_quality() const;
 
     // Setters
     void set_device_id(const std::string& value);
     void set_nickname(const std::string& value);
     void set_avatar_path(const std::string& value);
     void set_gameplay_recorder_enabled(bool value);
+    void set_code_data_logger_enabled(bool value);
+    void set_frame_skip_enabled(bool value);
+    void set_sprite_limit_enabled(bool value);
+    void set_audio_sample_rate(int value);
+    void set_audio_quality(int value);
 
 private:
     std::string generate_uuid();
@@ -40,6 +50,11 @@ private:
     std::string nickname_;
     std::string avatar_path_;
     bool gameplay_recorder_enabled_ = false;
+    bool code_data_logger_enabled_ = false;
+    bool frame_skip_enabled_ = false;
+    bool sprite_limit_enabled_ = false;
+    int audio_sample_rate_ = 48000;   // Hz, rate xin SDL (thiết bị có thể trả rate khác)
+    int audio_quality_ = 1;           // Resampler::Quality: 0 fast, 1 medium, 2 best
 };
 
 }
@@ -1,13 +1,38 @@
 #include "cpu/cpu.h"
 #include "memory/memory.h"
+#include "cartridge/code_data_logger.h"
+#ifdef NES_CPU_TRACE
+#include "cpu/cpu_trace.h"
+#endif
 #include <cstring>
 
 namespace nes {
 
+// Độ dài lệnh (opcode + operand bytes) theo opcode, cho Code/Data Logger
+static constexpr uint8_t INSTRUCTION_LENGTH[256] = {
+    1, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // 00
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // 10
+    3, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // 20
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // 30
+    1, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // 40
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // 50
+    1, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // 60
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // 70
+    2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // 80
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // 90
+    2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // A0
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // B0
+    2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // C0
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // D0
+    2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // E0
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // F0
+};
+
 CPU::CPU() 
     : A(0), X(0), Y(0), SP(0xFD), P(0x24),
-      PC(0), total_cycles(0), cycles_remaining(0),
-      memory_(nullptr) {
+      PC(0), total_cycles(0), total_instructions(0), cycles_remaining(0), stall_cycles_(0),
+      memory_(nullptr), irq_line_count_(0), profiler_(nullptr),
+      cdl_(nullptr), instruction_pc_(0), indirect_access_(false) {
 }
 
 CPU::~CPU() {
@@ -17,6 +42,15 @@ void CPU::connect_memory(Memory* memory) {
     memory_ = memory;
 }
 
+void CPU::connect_irq_line(const bool* line) {
+    for (int i = 0; i < irq_line_count_; i++) {
+        if (irq_lines_[i] == line) return;
+    }
+    if (irq_line_count_ < MAX_IRQ_LINES) {
+        irq_lines_[irq_line_count_++] = line;
+    }
+}
+
 void CPU::reset() {
     // Reset registers
     A = 0;
@@ -33,21 +67,48 @@ void CPU::reset() {
     }
     
     cycles_remaining = 7; // Reset mất 7 cycles
+    stall_cycles_ = 0;
     page_crossed_ = false;
 }
 
 int CPU::step() {
+    if (stall_cycles_ > 0) {
+        stall_cycles_--;
+        total_cycles++;
+        return 1;
+    }
+    
     if (cycles_remaining > 0) {
         cycles_remaining--;
         total_cycles++;
         return 1;
     }
     
-    // Đọc opcode
-    uint8_t opcode = read(PC++);
+    // Ranh giới instruction: poll IRQ line (bị chặn bởi flag I)
+    if (irq_asserted() && !get_flag(StatusFlag::FLAG_INTERRUPT)) {
+        irq();
+        // Cycle này là cycle đầu tiên trong 7 cycles của IRQ
+        cycles_remaining--;
+        total_cycles++;
+        return 1;
+    }
     
-    // Thực thi
-    execute(opcode);
+#ifdef NES_CPU_TRACE
+    if (tracer_) {
+        tracer_->record(*this, peek(PC));
+    }
+#endif
+    
+    instruction_pc_ = PC;
+    indirect_access_ = false;
+    
+    fetch_execute();
+    total_instructions++;
+    
+    // Hằng số compile-time: bị loại bỏ hoàn toàn khi không build NES_PROFILER
+    if (Profiler::ENABLED && profiler_) {
+        profile_instruction(instruction_pc_);
+    }
     
     // execute() đã set cycles_remaining, không cần decrement thêm!
     // cycles_remaining đã được set bởi execute() thành số cycles của instruction
@@ -56,6 +117,34 @@ int CPU::step() {
     return 1;
 }
 
+void CPU::profile_instruction(uint16_t pc) {
+    // Bank 8KB để phân biệt cùng PC ở các bank khác nhau
+    int32_t prg_offset = memory_->get_prg_offset(pc);
+    int32_t bank = (prg_offset >= 0) ? (prg_offset >> 13) : PROFILER_RAM_BANK;
+    
+    // cycles_remaining = tổng cycles - 1 (cycle đầu tiên đã tính trong step)
+    profiler_->on_instruction(pc, peek(pc), bank, cycles_remaining + 1);
+}
+
+void CPU::fetch_execute() {
+    // Đọc opcode
+    uint8_t opcode = read(PC++);
+    
+    // CDL: lấy offset trước khi thực thi, lệnh có thể ghi mapper và đổi bank của chính nó
+    int32_t prg_offset = cdl_ ? memory_->get_prg_offset(instruction_pc_) : -1;
+    
+    // Thực thi
+    execute(opcode);
+    
+    if (cdl_) {
+        cdl_->log_instruction(prg_offset, INSTRUCTION_LENGTH[opcode], instruction_pc_);
+        if (opcode == 0x6C) {
+            // JMP (ind): đích nhảy là code được tham chiếu gián tiếp
+            cdl_->log_prg(memory_->get_prg_offset(PC), CDL_PRG_INDIRECT_CODE, PC);
+        }
+    }
+}
+
 void CPU::irq() {
     if (!get_flag(StatusFlag::FLAG_INTERRUPT)) {
         push16(PC);
@@ -101,6 +190,19 @@ void CPU::update_zero_negative(uint8_t value) {
 // =====================
 
 uint8_t CPU::read(uint16_t address) {
+    // Code/Data Logger: đọc PRG ROM ngoài các byte của lệnh hiện tại là đọc data
+    if (cdl_ && address >= 0x8000 && static_cast<uint16_t>(address - instruction_pc_) >= 3) {
+        uint8_t flags = indirect_access_ ? (CDL_PRG_DATA | CDL_PRG_INDIRECT_DATA) : CDL_PRG_DATA;
+        cdl_->log_prg(memory_->get_prg_offset(address), flags, address);
+    }
+    
+    if (memory_) {
+        return memory_->read(address);
+    }
+    return 0;
+}
+
+uint8_t CPU::peek(uint16_t address) {
     if (memory_) {
         return memory_->read(address);
     }
@@ -215,12 +317,14 @@ uint16_t CPU::addr_indirect() {
 }
 
 uint16_t CPU::addr_indirect_x() {
+    indirect_access_ = true;
     uint8_t ptr = read(PC++) + X;
     // Must use zero page wraparound when reading pointer
     return read16_zp(ptr);
 }
 
 uint16_t CPU::addr_indirect_y() {
+    indirect_access_ = true;
     uint8_t ptr = read(PC++);
     // Must use zero page wraparound when reading pointer
     uint16_t base = read16_zp(ptr);
@@ -3,11 +3,14 @@
 
 #include <cstdint>
 #include <functional>
+#include "cpu/profiler.h"
 
 namespace nes {
 
 // Forward declaration
 class Memory;
+class CpuTracer;
+class CodeDataLogger;
 
 /**
  * @brief Ricoh 2A03 CPU (6502 variant)
@@ -46,6 +49,41 @@ public:
      */
     void nmi();
     
+    /**
+     * @brief Kết nối một nguồn IRQ (level-triggered, vd. mapper IRQ)
+     * CPU poll tất cả các line ở ranh giới instruction
+     */
+    void connect_irq_line(const bool* line);
+    
+    /**
+     * @brief CPU bị DMA chiếm bus: dừng thêm n cycles sau lệnh hiện tại
+     * Cycles vẫn được tính (PPU/APU chạy bình thường), NMI không xoá phần stall.
+     */
+    void add_stall_cycles(int cycles) { stall_cycles_ += cycles; }
+    
+    /**
+     * @brief Số thứ tự cycle bus đang thực hiện (cycle cuối của lệnh đang chạy)
+     * Dùng để căn DMA theo cycle chẵn/lẻ.
+     */
+    uint64_t get_bus_cycle() const { return total_cycles + cycles_remaining; }
+    
+    /**
+     * @brief Kết nối profiler (chỉ có tác dụng khi build với NES_PROFILER)
+     */
+    void connect_profiler(Profiler* profiler) { profiler_ = profiler; }
+    
+    /**
+     * @brief Kết nối Code/Data Logger (nullptr = tắt)
+     */
+    void connect_cdl(CodeDataLogger* cdl) { cdl_ = cdl; }
+    
+#ifdef NES_CPU_TRACE
+    /**
+     * @brief Gắn trace recorder (nullptr = tắt trace)
+     */
+    void set_tracer(CpuTracer* tracer) { tracer_ = tracer; }
+#endif
+    
     // Registers (8-bit)
     uint8_t A;   // Accumulator
     uint8_t X;   // Index Register X
@@ -59,9 +97,15 @@ public:
     // Tổng số cycles đã thực thi
     uint64_t total_cycles;
     
+    // Tổng số lệnh đã thực thi
+    uint64_t total_instructions;
+    
     // Cycles còn lại của lệnh hiện tại
     int cycles_remaining;
     
+    // Cycles CPU bị DMA dừng (OAM DMA, DMC)
+    int stall_cycles_;
+    
     // Flag to track page boundary crossing
     bool page_crossed_;
 
@@ -162,6 +206,33 @@ public:
 private:
     Memory* memory_;
     
+    // IRQ lines (mapper, APU, ...)
+    static constexpr int MAX_IRQ_LINES = 4;
+    const bool* irq_lines_[MAX_IRQ_LINES];
+    int irq_line_count_;
+    
+    bool irq_asserted() const {
+        for (int i = 0; i < irq_line_count_; i++) {
+            if (*irq_lines_[i]) return true;
+        }
+        return false;
+    }
+    
+    // Profiler
+    Profiler* profiler_;
+    void profile_instruction(uint16_t pc);
+    
+    // Code/Data Logger
+    CodeDataLogger* cdl_;
+    uint16_t instruction_pc_;   // PC của lệnh đang thực thi
+    bool indirect_access_;      // Lệnh hiện tại dùng (zp,X) / (zp),Y
+    
+    void fetch_execute();
+    
+#ifdef NES_CPU_TRACE
+    CpuTracer* tracer_ = nullptr;
+#endif
+    
     // Processor Status Flags
     enum class StatusFlag : uint8_t {
         FLAG_CARRY     = 0x01,  // Bit 0: Carry
@@ -181,6 +252,7 @@ private:
     
     // Memory access
     uint8_t read(uint16_t address);
+    uint8_t peek(uint16_t address);  // Đọc không log CDL (decode / debug)
     void write(uint16_t address, uint8_t value);
     uint16_t read16(uint16_t address);
     
@@ -0,0 +1,125 @@
+#include "cpu/cpu_trace.h"
+#include "cpu/cpu.h"
+#include "ppu/ppu.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace nes {
+
+CpuTracer::CpuTracer()
+    : ring_(RING_SIZE), head_(0), tail_(0), running_(false), active_(false),
+      file_(nullptr), ppu_(nullptr), record_count_(0) {
+}
+
+CpuTracer::~CpuTracer() {
+    stop();
+}
+
+bool CpuTracer::start(const std::string& filename) {
+    stop();
+
+    file_ = fopen(filename.c_str(), "wb");
+    if (!file_) {
+        return false;
+    }
+
+    TraceFileHeader header;
+    std::memcpy(header.magic, "NESTRACE", 8);
+    header.version = TRACE_FILE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    fwrite(&header, sizeof(header), 1, file_);
+
+    head_.store(0);
+    tail_.store(0);
+    record_count_ = 0;
+
+    running_ = true;
+    active_ = true;
+    writer_thread_ = std::thread(&CpuTracer::writer_loop, this);
+    return true;
+}
+
+void CpuTracer::stop() {
+    if (!active_) {
+        return;
+    }
+
+    running_ = false;
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+
+    fclose(file_);
+    file_ = nullptr;
+    active_ = false;
+}
+
+void CpuTracer::record(const CPU& cpu, uint8_t opcode) {
+    size_t head = head_.load(std::memory_order_relaxed);
+
+    // Ring đầy: chờ writer (không drop record)
+    while (head - tail_.load(std::memory_order_acquire) >= RING_SIZE) {
+        std::this_thread::yield();
+    }
+
+    TraceRecord& rec = ring_[head & (RING_SIZE - 1)];
+    rec.cycle = cpu.total_cycles;
+    rec.pc = cpu.PC;
+    rec.opcode = opcode;
+    rec.a = cpu.A;
+    rec.x = cpu.X;
+    rec.y = cpu.Y;
+    rec.p = cpu.P;
+    rec.sp = cpu.SP;
+    rec.scanline = ppu_ ? static_cast<int16_t>(ppu_->get_scanline()) : 0;
+    rec.dot = ppu_ ? static_cast<uint16_t>(ppu_->get_cycle()) : 0;
+    rec.reserved = 0;
+
+    head_.store(head + 1, std::memory_order_release);
+    record_count_++;
+}
+
+size_t CpuTracer::drain(std::vector<TraceRecord>& chunk) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t count = head - tail;
+    if (count == 0) {
+        return 0;
+    }
+
+    // Copy tối đa 2 đoạn (ring có thể wrap)
+    size_t start = tail & (RING_SIZE - 1);
+    size_t first = std::min(count, RING_SIZE - start);
+    chunk.assign(ring_.begin() + start, ring_.begin() + start + first);
+    if (first < count) {
+        chunk.insert(chunk.end(), ring_.begin(), ring_.begin() + (count - first));
+    }
+
+    tail_.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+void CpuTracer::writer_loop() {
+    std::vector<TraceRecord> chunk;
+    chunk.reserve(RING_SIZE);
+
+    while (true) {
+        // Đọc running_ trước khi drain: sau khi stop() được gọi, lần drain này
+        // chắc chắn thấy mọi record CPU đã đẩy vào
+        bool running = running_.load();
+        size_t count = drain(chunk);
+
+        if (count > 0) {
+            fwrite(chunk.data(), sizeof(TraceRecord), count, file_);
+        } else if (!running) {
+            break;
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    fflush(file_);
+}
+
+} // namespace nes
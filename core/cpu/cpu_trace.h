@@ -0,0 +1,112 @@
+#ifndef NES_CPU_TRACE_H
+#define NES_CPU_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+
+namespace nes {
+
+// Forward declarations
+class CPU;
+class PPU;
+
+/**
+ * @brief Một record trace (kích thước cố định, ghi thẳng ra file)
+ *
+ * Trạng thái CPU *trước* khi thực thi lệnh tại pc (giống format nestest.log).
+ */
+struct TraceRecord {
+    uint64_t cycle;      // CPU cycle (total_cycles)
+    uint16_t pc;
+    uint8_t opcode;
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t p;
+    uint8_t sp;
+    int16_t scanline;    // PPU scanline (-1..260)
+    uint16_t dot;        // PPU cycle trong scanline (0..340)
+    uint32_t reserved;   // Padding, luôn = 0
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must stay 24 bytes (file format)");
+
+/**
+ * @brief Header đầu file trace
+ */
+struct TraceFileHeader {
+    char magic[8];         // "NESTRACE"
+    uint32_t version;
+    uint32_t record_size;  // sizeof(TraceRecord)
+};
+
+static constexpr uint32_t TRACE_FILE_VERSION = 1;
+
+/**
+ * @brief Ghi trace CPU dạng binary
+ *
+ * CPU đẩy record vào ring buffer lock-free (single producer / single consumer),
+ * writer thread gom và ghi ra đĩa theo từng khối lớn. Khi ring đầy, CPU chờ
+ * writer thay vì bỏ record, để trace luôn đầy đủ cho việc diff.
+ *
+ * Chỉ được nối vào CPU khi build với NES_CPU_TRACE.
+ */
+class CpuTracer {
+public:
+    // Số record trong ring (power of 2)
+    static constexpr size_t RING_SIZE = 1 << 16;
+
+    CpuTracer();
+    ~CpuTracer();
+
+    /**
+     * @brief Mở file và khởi động writer thread
+     */
+    bool start(const std::string& filename);
+
+    /**
+     * @brief Flush phần còn lại, dừng writer thread và đóng file
+     */
+    void stop();
+
+    bool is_active() const { return active_; }
+
+    /**
+     * @brief PPU dùng để lấy scanline/dot (có thể null)
+     */
+    void connect_ppu(const PPU* ppu) { ppu_ = ppu; }
+
+    /**
+     * @brief Ghi trạng thái CPU trước khi thực thi opcode tại cpu.PC
+     */
+    void record(const CPU& cpu, uint8_t opcode);
+
+    /**
+     * @brief Tổng số record đã ghi (kể cả phần còn trong ring)
+     */
+    uint64_t get_record_count() const { return record_count_; }
+
+private:
+    void writer_loop();
+    size_t drain(std::vector<TraceRecord>& chunk);
+
+    std::vector<TraceRecord> ring_;
+    std::atomic<size_t> head_;   // Producer (CPU thread) ghi
+    std::atomic<size_t> tail_;   // Consumer (writer thread) ghi
+
+    std::thread writer_thread_;
+    std::atomic<bool> running_;
+    bool active_;
+
+    FILE* file_;
+    const PPU* ppu_;
+    uint64_t record_count_;
+};
+
+} // namespace nes
+
+#endif // NES_CPU_TRACE_H
@@ -0,0 +1,58 @@
+#include "cpu/profiler.h"
+#include <algorithm>
+
+namespace nes {
+
+ProfilerPolicy<true>::ProfilerPolicy() {
+    reset();
+}
+
+void ProfilerPolicy<true>::reset() {
+    bank_cycles_.clear();
+    last_bank_ = PROFILER_RAM_BANK;
+    last_table_ = &bank_table(PROFILER_RAM_BANK);
+
+    opcode_counts_.fill(0);
+    opcode_cycles_.fill(0);
+    ppu_reads_.fill(0);
+    ppu_writes_.fill(0);
+    apu_reads_.fill(0);
+    apu_writes_.fill(0);
+
+    total_cycles_ = 0;
+    total_instructions_ = 0;
+}
+
+std::vector<uint64_t>& ProfilerPolicy<true>::bank_table(int32_t bank) {
+    std::vector<uint64_t>& table = bank_cycles_[bank];
+    if (table.empty()) {
+        table.resize(0x10000, 0);
+    }
+    return table;
+}
+
+std::vector<ProfileEntry> ProfilerPolicy<true>::get_hot_spots(size_t max_entries) const {
+    std::vector<ProfileEntry> entries;
+    for (const auto& bank : bank_cycles_) {
+        const std::vector<uint64_t>& table = bank.second;
+        for (uint32_t pc = 0; pc < table.size(); pc++) {
+            if (table[pc] != 0) {
+                entries.push_back({bank.first, static_cast<uint16_t>(pc), table[pc]});
+            }
+        }
+    }
+
+    auto by_cycles = [](const ProfileEntry& a, const ProfileEntry& b) {
+        return a.cycles > b.cycles;
+    };
+
+    if (entries.size() > max_entries) {
+        std::partial_sort(entries.begin(), entries.begin() + max_entries, entries.end(), by_cycles);
+        entries.resize(max_entries);
+    } else {
+        std::sort(entries.begin(), entries.end(), by_cycles);
+    }
+    return entries;
+}
+
+} // namespace nes
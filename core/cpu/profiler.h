@@ -0,0 +1,140 @@
+#ifndef NES_PROFILER_H
+#define NES_PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <map>
+#include <vector>
+
+namespace nes {
+
+/**
+ * @brief Một PC "nóng" trong guest code
+ */
+struct ProfileEntry {
+    int32_t bank;     // PRG bank 8KB (PROFILER_RAM_BANK nếu chạy từ RAM)
+    uint16_t pc;
+    uint64_t cycles;
+};
+
+// Bank id cho code không nằm trong PRG ROM (internal RAM / PRG RAM)
+static constexpr int32_t PROFILER_RAM_BANK = -1;
+
+// Số thanh ghi được đếm: PPU $2000-$2007, APU/IO $4000-$4017
+static constexpr int PROFILER_PPU_REGS = 8;
+static constexpr int PROFILER_APU_REGS = 0x18;
+
+/**
+ * @brief Profiler guest code, chọn lúc compile bằng template policy
+ *
+ * ProfilerPolicy<false>: mọi hook là hàm inline rỗng, CPU/Memory kiểm tra
+ * Profiler::ENABLED (hằng số compile-time) nên toàn bộ code profile bị loại bỏ.
+ * ProfilerPolicy<true>: đếm cycles theo (bank, PC), số lần mỗi opcode và số
+ * lần truy cập thanh ghi PPU/APU.
+ */
+template <bool Enabled>
+class ProfilerPolicy;
+
+template <>
+class ProfilerPolicy<false> {
+public:
+    static constexpr bool ENABLED = false;
+
+    void on_instruction(uint16_t, uint8_t, int32_t, int) {}
+    void on_register_read(uint16_t) {}
+    void on_register_write(uint16_t) {}
+    void reset() {}
+};
+
+template <>
+class ProfilerPolicy<true> {
+public:
+    static constexpr bool ENABLED = true;
+
+    ProfilerPolicy();
+
+    /**
+     * @brief Gọi sau mỗi lệnh CPU
+     * @param bank PRG bank 8KB chứa lệnh (PROFILER_RAM_BANK nếu chạy từ RAM)
+     * @param cycles Số cycles lệnh đã tốn
+     */
+    void on_instruction(uint16_t pc, uint8_t opcode, int32_t bank, int cycles) {
+        if (bank != last_bank_) {
+            last_table_ = &bank_table(bank);
+            last_bank_ = bank;
+        }
+        (*last_table_)[pc] += cycles;
+        opcode_counts_[opcode]++;
+        opcode_cycles_[opcode] += cycles;
+        total_cycles_ += cycles;
+        total_instructions_++;
+    }
+
+    /**
+     * @brief Gọi từ Memory cho các địa chỉ $2000-$3FFF và $4000-$4017
+     */
+    void on_register_read(uint16_t address) {
+        if (address < 0x4000) {
+            ppu_reads_[address & 0x0007]++;
+        } else {
+            apu_reads_[address - 0x4000]++;
+        }
+    }
+
+    void on_register_write(uint16_t address) {
+        if (address < 0x4000) {
+            ppu_writes_[address & 0x0007]++;
+        } else {
+            apu_writes_[address - 0x4000]++;
+        }
+    }
+
+    /**
+     * @brief Xoá toàn bộ số liệu (đổi game / bắt đầu đo lại)
+     */
+    void reset();
+
+    /**
+     * @brief Các PC tốn nhiều cycles nhất, sắp xếp giảm dần
+     */
+    std::vector<ProfileEntry> get_hot_spots(size_t max_entries) const;
+
+    const std::array<uint64_t, 256>& get_opcode_counts() const { return opcode_counts_; }
+    const std::array<uint64_t, 256>& get_opcode_cycles() const { return opcode_cycles_; }
+    const std::array<uint64_t, PROFILER_PPU_REGS>& get_ppu_reads() const { return ppu_reads_; }
+    const std::array<uint64_t, PROFILER_PPU_REGS>& get_ppu_writes() const { return ppu_writes_; }
+    const std::array<uint64_t, PROFILER_APU_REGS>& get_apu_reads() const { return apu_reads_; }
+    const std::array<uint64_t, PROFILER_APU_REGS>& get_apu_writes() const { return apu_writes_; }
+    uint64_t get_total_cycles() const { return total_cycles_; }
+    uint64_t get_total_instructions() const { return total_instructions_; }
+
+private:
+    std::vector<uint64_t>& bank_table(int32_t bank);
+
+    // Bảng 64K cycles cho mỗi bank (std::map giữ địa chỉ vector ổn định)
+    std::map<int32_t, std::vector<uint64_t>> bank_cycles_;
+    int32_t last_bank_;
+    std::vector<uint64_t>* last_table_;
+
+    std::array<uint64_t, 256> opcode_counts_;
+    std::array<uint64_t, 256> opcode_cycles_;
+
+    std::array<uint64_t, PROFILER_PPU_REGS> ppu_reads_;
+    std::array<uint64_t, PROFILER_PPU_REGS> ppu_writes_;
+    std::array<uint64_t, PROFILER_APU_REGS> apu_reads_;
+    std::array<uint64_t, PROFILER_APU_REGS> apu_writes_;
+
+    uint64_t total_cycles_;
+    uint64_t total_instructions_;
+};
+
+#ifdef NES_PROFILER
+using Profiler = ProfilerPolicy<true>;
+#else
+using Profiler = ProfilerPolicy<false>;
+#endif
+
+} // namespace nes
+
+#endif // NES_PROFILER_H
@@ -4,11 +4,17 @@
 
 namespace nes {
 
-Emulator::Emulator() : master_clock_(0), audio_time_(0.0) {
+Emulator::Emulator() : native_phase_(0), audio_rate_ratio_(1.0), master_clock_(0), cdl_enabled_(false) {
     memset(framebuffer_, 0, sizeof(framebuffer_));
     
+    // 1 frame ~ 1241 native samples
+    native_samples_.reserve(2048);
+    apu_.set_sample_rate(native_sample_rate());
+    set_audio_output(44100.0);
+    
     // Kết nối các component
     cpu_.connect_memory(&memory_);
+    memory_.connect_cpu(&cpu_);
     memory_.connect_ppu(&ppu_);
     memory_.connect_apu(&apu_);
     memory_.connect_input(&input_);
@@ -17,15 +23,100 @@ Emulator::Emulator() : master_clock_(0), audio_time_(0.0) {
     // PPU cần access cartridge để đọc CHR ROM (pattern tables)
     ppu_.connect_cartridge(&cartridge_);
     
-    // APU cần access memory cho DMC
+    // Mapper IRQ (MMC3 scanline counter)
+    cpu_.connect_irq_line(cartridge_.get_irq_line());
+    
+    // APU cần access memory cho DMC (và CPU để báo stall khi DMC đọc sample)
     apu_.connect_memory(&memory_);
+    apu_.connect_cpu(&cpu_);
+    
+    // APU IRQ (frame counter + DMC)
+    cpu_.connect_irq_line(apu_.get_irq_line());
+    
+    // Profiler (no-op nếu không build với NES_PROFILER)
+    cpu_.connect_profiler(&profiler_);
+    memory_.connect_profiler(&profiler_);
 }
 
 Emulator::~Emulator() {
+    save_cdl();
+#ifdef NES_CPU_TRACE
+    stop_cpu_trace();
+#endif
+}
+
+#ifdef NES_CPU_TRACE
+bool Emulator::start_cpu_trace(const std::string& filename) {
+    cpu_tracer_.connect_ppu(&ppu_);
+    if (!cpu_tracer_.start(filename)) {
+        return false;
+    }
+    cpu_.set_tracer(&cpu_tracer_);
+    return true;
+}
+
+void Emulator::stop_cpu_trace() {
+    cpu_.set_tracer(nullptr);
+    cpu_tracer_.stop();
 }
+#endif
 
 bool Emulator::load_rom(const std::string& filename) {
-    return cartridge_.load_from_file(filename);
+    profiler_.reset();
+    
+    // Lưu CDL của ROM cũ trước khi đổi
+    save_cdl();
+    cdl_path_.clear();
+    
+    if (!cartridge_.load_from_file(filename)) {
+        attach_cdl();
+        return false;
+    }
+    apu_.invalidate_prg_pages();
+    
+    // <rom>.nes -> <rom>.cdl
+    size_t dot = filename.find_last_of('.');
+    size_t slash = filename.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        cdl_path_ = filename.substr(0, dot) + ".cdl";
+    } else {
+        cdl_path_ = filename + ".cdl";
+    }
+    
+    cdl_.reset(cartridge_.get_prg_size(), cartridge_.get_chr_size());
+    if (cdl_enabled_) {
+        cdl_.load(cdl_path_);
+    }
+    attach_cdl();
+    return true;
+}
+
+void Emulator::set_cdl_enabled(bool enabled) {
+    if (enabled == cdl_enabled_) return;
+    
+    if (!enabled) {
+        save_cdl();
+    } else if (!cdl_path_.empty()) {
+        cdl_.clear();
+        cdl_.load(cdl_path_);
+    }
+    
+    cdl_enabled_ = enabled;
+    attach_cdl();
+}
+
+bool Emulator::save_cdl() {
+    if (!cdl_enabled_ || cdl_path_.empty()) {
+        return false;
+    }
+    return cdl_.save(cdl_path_);
+}
+
+void Emulator::attach_cdl() {
+    // Chỉ gắn hook khi có ROM: CPU/PPU kiểm tra null nên khi tắt gần như không tốn gì
+    CodeDataLogger* cdl = (cdl_enabled_ && !cdl_path_.empty()) ? &cdl_ : nullptr;
+    cpu_.connect_cdl(cdl);
+    ppu_.connect_cdl(cdl);
 }
 
 void Emulator::reset() {
@@ -36,8 +127,10 @@ void Emulator::reset() {
     memory_.reset();
     cartridge_.reset();
     master_clock_ = 0;
-    audio_time_ = 0.0;
+    native_phase_ = 0;
     audio_samples_.clear();
+    native_samples_.clear();
+    resampler_.reset();
 }
 
 void Emulator::run_frame() {
@@ -48,12 +141,9 @@ void Emulator::run_frame() {
     const int CYCLES_PER_FRAME = 29781;
     int cycles = 0;
     
-    // Audio settings
-    const double CPU_FREQ = 1789773.0;
-    const double SAMPLE_RATE = 44100.0;
-    const double CYCLES_PER_SAMPLE = CPU_FREQ / SAMPLE_RATE;
-    
     audio_samples_.clear();
+    native_samples_.clear();
+    apu_.clear_channel_streams();
     
     int instruction_count = 0;
     
@@ -86,18 +176,24 @@ void Emulator::run_frame() {
             }
         }
         
-        // APU step & Audio Sampling
-        for (int i = 0; i < cpu_cycles; i++) {
-            apu_.step();
-            
-            audio_time_ += 1.0;
-            if (audio_time_ >= CYCLES_PER_SAMPLE) {
-                audio_time_ -= CYCLES_PER_SAMPLE;
-                audio_samples_.push_back(apu_.get_sample());
-            }
+        // APU chạy lazy: chỉ catch up khi cần sample (hoặc khi có event / register access)
+        apu_.add_cycles(cpu_cycles);
+        
+        // Audio Sampling (native rate, khoảng cách cố định nên không cần đếm số thực)
+        native_phase_ += cpu_cycles;
+        while (native_phase_ >= NATIVE_SAMPLE_DIVIDER) {
+            native_phase_ -= NATIVE_SAMPLE_DIVIDER;
+            apu_.catch_up();
+            native_samples_.push_back(apu_.mix_sample());
         }
     }
     
+    apu_.catch_up();
+    
+    // Native rate -> output rate (rate control chỉ đổi bước của resampler)
+    resampler_.set_rate_ratio(audio_rate_ratio_);
+    resampler_.process(native_samples_.data(), native_samples_.size(), audio_samples_);
+    
     master_clock_ += CYCLES_PER_FRAME;
 }
 
@@ -122,4 +218,13 @@ const std::vector<float>& Emulator::get_audio_samples() const {
     return audio_samples_;
 }
 
+void Emulator::set_audio_output(double sample_rate, Resampler::Quality quality) {
+    resampler_.configure(native_sample_rate(), sample_rate, quality);
+}
+
+void Emulator::set_channel_capture(bool enabled) {
+    // 1 frame ~ 1241 native samples, dư cho frame dài
+    apu_.set_channel_capture(enabled, 2048);
+}
+
 } // namespace nes
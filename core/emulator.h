@@ -4,9 +4,14 @@
 #include "cpu/cpu.h"
 #include "ppu/ppu.h"
 #include "apu/apu.h"
+#include "apu/resampler.h"
 #include "input/input.h"
 #include "memory/memory.h"
 #include "cartridge/cartridge.h"
+#include "cartridge/code_data_logger.h"
+#ifdef NES_CPU_TRACE
+#include "cpu/cpu_trace.h"
+#endif
 
 namespace nes {
 
@@ -40,6 +45,34 @@ public:
      */
     const uint8_t* get_framebuffer() const;
     
+    /**
+     * @brief PPU ghi thẳng vào surface ngoài (texture đã lock, buffer của frontend...)
+     * Khi đã set, get_framebuffer() không còn được cập nhật. pixels = nullptr để bỏ.
+     */
+    void set_output_surface(uint8_t* pixels, int pitch, PixelFormat format) {
+        ppu_.set_output_surface(pixels, pitch, format);
+    }
+    
+    /**
+     * @brief Tắt ghi pixel cho các frame không hiển thị (fast-forward, frame skip)
+     * Trạng thái game không đổi: PPU vẫn chạy đủ, chỉ bỏ bước tạo ảnh.
+     */
+    void set_pixel_output_enabled(bool enabled) { ppu_.set_pixel_output_enabled(enabled); }
+    
+    /**
+     * @brief Giới hạn 8 sprite/scanline + sprite overflow như phần cứng (mặc định tắt)
+     */
+    void set_sprite_limit_enabled(bool enabled) { ppu_.set_sprite_limit_enabled(enabled); }
+    
+    /**
+     * @brief Các scanline thay đổi kể từ lần clear_dirty_rows() trước (bit y = dòng y)
+     * Frontend lấy mask sau khi dùng frame rồi clear, để bỏ qua upload/encode các dòng
+     * không đổi. Cộng dồn qua nhiều run_frame() nếu chưa clear.
+     */
+    const std::array<uint64_t, 4>& get_dirty_rows() const { return ppu_.get_dirty_rows(); }
+    bool frame_changed() const { return ppu_.frame_changed(); }
+    void clear_dirty_rows() { ppu_.clear_dirty_rows(); }
+    
     /**
      * @brief Set controller input
      * @param controller 0 hoặc 1
@@ -59,10 +92,77 @@ public:
      */
     const std::vector<float>& get_audio_samples() const;
     
+    /**
+     * @brief Chỉnh tỉ lệ sinh audio samples (dynamic rate control)
+     * @param ratio 1.0 = đúng output sample rate, 1.005 = sinh nhiều hơn 0.5%
+     */
+    void set_audio_rate_ratio(double ratio) { audio_rate_ratio_ = ratio; }
+    
+    /**
+     * @brief Sample rate của get_audio_samples() (rate thật của sound card) và
+     *        chất lượng resampler từ native rate của APU
+     */
+    void set_audio_output(double sample_rate, Resampler::Quality quality = Resampler::QUALITY_MEDIUM);
+    double get_output_sample_rate() const { return resampler_.get_output_rate(); }
+    
+    // NTSC CPU clock; APU được lấy mẫu mỗi NATIVE_SAMPLE_DIVIDER CPU cycles (~74.6 kHz)
+    static constexpr double CPU_CLOCK_HZ = 1789773.0;
+    static constexpr int NATIVE_SAMPLE_DIVIDER = 24;
+    static constexpr double native_sample_rate() { return CPU_CLOCK_HZ / NATIVE_SAMPLE_DIVIDER; }
+    
+    /**
+     * @brief Bật/tắt per-channel audio stream (visualizer, export stem)
+     * Buffer được cấp phát trước đủ cho 1 frame.
+     */
+    void set_channel_capture(bool enabled);
+    
+    /**
+     * @brief Samples của 1 channel trong frame vừa chạy, ở native_sample_rate()
+     */
+    const std::vector<float>& get_channel_samples(APU::Channel channel) const {
+        return apu_.get_channel_stream(channel);
+    }
+    
     /**
      * @brief Get PPU for debug access
      */
     PPU& get_ppu() { return ppu_; }
+    
+    /**
+     * @brief Get cartridge (PRG ROM cho báo cáo profiler)
+     */
+    Cartridge& get_cartridge() { return cartridge_; }
+    
+    /**
+     * @brief Guest code profiler (chỉ đếm khi build với NES_PROFILER)
+     */
+    Profiler& get_profiler() { return profiler_; }
+    
+    /**
+     * @brief Bật/tắt Code/Data Logger
+     * Khi bật, file <rom>.cdl được load lúc load ROM và lưu lại khi đổi ROM / thoát
+     */
+    void set_cdl_enabled(bool enabled);
+    bool is_cdl_enabled() const { return cdl_enabled_; }
+    
+    /**
+     * @brief Lưu CDL của ROM hiện tại ra file .cdl
+     */
+    bool save_cdl();
+    
+    const CodeDataLogger& get_cdl() const { return cdl_; }
+    
+#ifdef NES_CPU_TRACE
+    /**
+     * @brief Bắt đầu ghi binary CPU trace ra file
+     */
+    bool start_cpu_trace(const std::string& filename);
+    
+    /**
+     * @brief Dừng trace (flush phần còn lại ra đĩa)
+     */
+    void stop_cpu_trace();
+#endif
 
     // Public access cho testing (TODO: Remove sau khi có proper API)
     CPU cpu_;
@@ -76,12 +176,28 @@ private:
     
     uint8_t framebuffer_[256 * 240 * 4]; // RGBA
     
-    // Audio
+    // Audio: APU lấy mẫu ở native rate, resample 1 lần mỗi frame sang output rate
     std::vector<float> audio_samples_;
-    double audio_time_;
+    std::vector<float> native_samples_;
+    int native_phase_;      // CPU cycles kể từ native sample trước
+    double audio_rate_ratio_;
+    Resampler resampler_;
     
     // Đồng bộ CPU/PPU timing
     int master_clock_;
+    
+    Profiler profiler_;
+    
+    // Code/Data Logger
+    CodeDataLogger cdl_;
+    bool cdl_enabled_;
+    std::string cdl_path_;  // Rỗng khi chưa load ROM
+    
+    void attach_cdl();
+    
+#ifdef NES_CPU_TRACE
+    CpuTracer cpu_tracer_;
+#endif
 };
 
 } // namespace nes
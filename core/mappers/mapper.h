@@ -2,6 +2,7 @@
 #define NES_MAPPER_H
 
 #include <cstdint>
+#include <cstddef>
 
 namespace nes {
 
@@ -23,6 +24,31 @@ public:
     virtual MirrorMode get_mirroring() const { 
         return static_cast<MirrorMode>(0);  // Default: HORIZONTAL
     }
+    
+    // PRG ROM offset currently mapped at a CPU address ($8000-$FFFF).
+    // Returns -1 if the address is not backed by PRG ROM.
+    // Used by the profiler and Code/Data Logger to tell banks apart.
+    virtual int32_t get_prg_offset(uint16_t address) const {
+        (void)address;
+        return -1;
+    }
+    
+    // CHR offset currently mapped at a PPU address ($0000-$1FFF).
+    // Returns -1 if the address is not backed by CHR ROM/RAM.
+    // Used by the Code/Data Logger.
+    virtual int32_t get_chr_offset(uint16_t address) const {
+        (void)address;
+        return -1;
+    }
+    
+    // Cartridge IRQ line (level). Polled by the CPU at instruction boundaries
+    // through Cartridge, which caches it after every register write / A12 edge.
+    virtual bool irq_pending() const { return false; }
+    
+    // Mappers that count PPU A12 rising edges (MMC3 scanline counter).
+    // The PPU only tracks A12 when this returns true.
+    virtual bool uses_a12() const { return false; }
+    virtual void notify_a12_rise() {}
 };
 
 } // namespace nes
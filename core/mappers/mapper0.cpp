@@ -3,8 +3,8 @@
 
 namespace nes {
 
-Mapper0::Mapper0(uint8_t* prg_rom, size_t prg_size,
-                 uint8_t* chr_rom, size_t chr_size)
+Mapper0::Mapper0(const uint8_t* prg_rom, size_t prg_size,
+                 const uint8_t* chr_rom, size_t chr_size)
     : prg_rom_(prg_rom), chr_rom_(chr_rom),
       prg_size_(prg_size), chr_size_(chr_size) {
     
@@ -69,4 +69,15 @@ void Mapper0::reset() {
     // PRG RAM is persistent (for save games)
 }
 
+int32_t Mapper0::get_prg_offset(uint16_t address) const {
+    if (address < 0x8000) return -1;
+    uint32_t index = address & (prg_size_ == 0x4000 ? 0x3FFF : 0x7FFF);
+    return index < prg_size_ ? static_cast<int32_t>(index) : -1;
+}
+
+int32_t Mapper0::get_chr_offset(uint16_t address) const {
+    if (address >= 0x2000 || chr_size_ == 0) return -1;
+    return static_cast<int32_t>(address % chr_size_);
+}
+
 } // namespace nes
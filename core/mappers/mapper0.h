@@ -27,17 +27,20 @@ namespace nes {
  */
 class Mapper0 : public Mapper {
 public:
-    Mapper0(uint8_t* prg_rom, size_t prg_size,
-            uint8_t* chr_rom, size_t chr_size);
+    Mapper0(const uint8_t* prg_rom, size_t prg_size,
+            const uint8_t* chr_rom, size_t chr_size);
     ~Mapper0() override;
     
     uint8_t read(uint16_t address) override;
     void write(uint16_t address, uint8_t value) override;
     void reset() override;
+    
+    int32_t get_prg_offset(uint16_t address) const override;
+    int32_t get_chr_offset(uint16_t address) const override;
 
 private:
-    uint8_t* prg_rom_;
-    uint8_t* chr_rom_;
+    const uint8_t* prg_rom_;
+    const uint8_t* chr_rom_;
     uint8_t* prg_ram_;
     size_t prg_size_;
     size_t chr_size_;
@@ -3,8 +3,8 @@
 
 namespace nes {
 
-Mapper1::Mapper1(uint8_t* prg_rom, size_t prg_size,
-                 uint8_t* chr_rom, size_t chr_size)
+Mapper1::Mapper1(const uint8_t* prg_rom, size_t prg_size,
+                 const uint8_t* chr_rom, size_t chr_size)
     : prg_rom_(prg_rom), chr_rom_(chr_rom),
       prg_size_(prg_size), chr_size_(chr_size),
       shift_register_(0), shift_count_(0),
@@ -138,7 +138,19 @@ void Mapper1::update_mirroring() {
     }
 }
 
-uint32_t Mapper1::get_prg_bank_offset(uint16_t address) {
+int32_t Mapper1::get_prg_offset(uint16_t address) const {
+    if (address < 0x8000) return -1;
+    uint32_t offset = get_prg_bank_offset(address);
+    return offset < prg_size_ ? static_cast<int32_t>(offset) : -1;
+}
+
+int32_t Mapper1::get_chr_offset(uint16_t address) const {
+    if (address >= 0x2000) return -1;
+    uint32_t offset = get_chr_bank_offset(address);
+    return offset < chr_size_ ? static_cast<int32_t>(offset) : -1;
+}
+
+uint32_t Mapper1::get_prg_bank_offset(uint16_t address) const {
     uint32_t bank_number = 0;
     uint32_t offset_in_bank = address & 0x3FFF;  // 16KB bank size
     
@@ -186,7 +198,7 @@ uint32_t Mapper1::get_prg_bank_offset(uint16_t address) {
     return bank_number * 0x4000 + offset_in_bank;
 }
 
-uint32_t Mapper1::get_chr_bank_offset(uint16_t address) {
+uint32_t Mapper1::get_chr_bank_offset(uint16_t address) const {
     uint32_t bank_number = 0;
     uint32_t offset_in_bank = address & 0x0FFF;  // 4KB bank size
     
@@ -20,20 +20,23 @@ namespace nes {
  */
 class Mapper1 : public Mapper {
 public:
-    Mapper1(uint8_t* prg_rom, size_t prg_size,
-            uint8_t* chr_rom, size_t chr_size);
+    Mapper1(const uint8_t* prg_rom, size_t prg_size,
+            const uint8_t* chr_rom, size_t chr_size);
     ~Mapper1() override = default;
     
     uint8_t read(uint16_t address) override;
     void write(uint16_t address, uint8_t value) override;
     void reset() override;
     
+    int32_t get_prg_offset(uint16_t address) const override;
+    int32_t get_chr_offset(uint16_t address) const override;
+    
     MirrorMode get_mirroring() const { return mirror_mode_; }
 
 private:
     // ROM pointers
-    uint8_t* prg_rom_;
-    uint8_t* chr_rom_;
+    const uint8_t* prg_rom_;
+    const uint8_t* chr_rom_;
     size_t prg_size_;
     size_t chr_size_;
     
@@ -63,8 +66,8 @@ private:
     // Helper functions
     void write_control(uint8_t value);
     void update_mirroring();
-    uint32_t get_prg_bank_offset(uint16_t address);
-    uint32_t get_chr_bank_offset(uint16_t address);
+    uint32_t get_prg_bank_offset(uint16_t address) const;
+    uint32_t get_chr_bank_offset(uint16_t address) const;
 };
 
 } // namespace nes
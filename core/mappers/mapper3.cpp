@@ -2,8 +2,8 @@
 
 namespace nes {
 
-Mapper3::Mapper3(uint8_t* prg_rom, size_t prg_size,
-                 uint8_t* chr_rom, size_t chr_size)
+Mapper3::Mapper3(const uint8_t* prg_rom, size_t prg_size,
+                 const uint8_t* chr_rom, size_t chr_size)
     : prg_rom_(prg_rom), chr_rom_(chr_rom),
       prg_size_(prg_size), chr_size_(chr_size),
       chr_bank_(0) {
@@ -45,4 +45,16 @@ void Mapper3::write(uint16_t address, uint8_t value) {
     }
 }
 
+int32_t Mapper3::get_prg_offset(uint16_t address) const {
+    if (address < 0x8000) return -1;
+    uint32_t offset = address & (prg_size_ == 0x4000 ? 0x3FFF : 0x7FFF);
+    return offset < prg_size_ ? static_cast<int32_t>(offset) : -1;
+}
+
+int32_t Mapper3::get_chr_offset(uint16_t address) const {
+    if (address >= 0x2000) return -1;
+    uint32_t offset = (chr_bank_ * 0x2000) + address;
+    return offset < chr_size_ ? static_cast<int32_t>(offset) : -1;
+}
+
 } // namespace nes
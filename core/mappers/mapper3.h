@@ -17,17 +17,20 @@ namespace nes {
  */
 class Mapper3 : public Mapper {
 public:
-    Mapper3(uint8_t* prg_rom, size_t prg_size,
-            uint8_t* chr_rom, size_t chr_size);
+    Mapper3(const uint8_t* prg_rom, size_t prg_size,
+            const uint8_t* chr_rom, size_t chr_size);
     ~Mapper3() override = default;
     
     uint8_t read(uint16_t address) override;
     void write(uint16_t address, uint8_t value) override;
     void reset() override;
+    
+    int32_t get_prg_offset(uint16_t address) const override;
+    int32_t get_chr_offset(uint16_t address) const override;
 
 private:
-    uint8_t* prg_rom_;
-    uint8_t* chr_rom_;
+    const uint8_t* prg_rom_;
+    const uint8_t* chr_rom_;
     size_t prg_size_;
     size_t chr_size_;
     
@@ -3,8 +3,8 @@
 
 namespace nes {
 
-Mapper4::Mapper4(uint8_t* prg_rom, size_t prg_size,
-                 uint8_t* chr_rom, size_t chr_size)
+Mapper4::Mapper4(const uint8_t* prg_rom, size_t prg_size,
+                 const uint8_t* chr_rom, size_t chr_size)
     : prg_rom_(prg_rom), chr_rom_(chr_rom),
       prg_size_(prg_size), chr_size_(chr_size),
       bank_select_(0), prg_mode_(false), chr_a12_inversion_(false),
@@ -126,7 +126,7 @@ void Mapper4::write(uint16_t address, uint8_t value) {
     }
 }
 
-void Mapper4::notify_scanline() {
+void Mapper4::notify_a12_rise() {
     // MMC3 scanline counter
     if (irq_counter_ == 0 || irq_reload_) {
         irq_counter_ = irq_latch_;
@@ -141,7 +141,19 @@ void Mapper4::notify_scanline() {
     }
 }
 
-uint32_t Mapper4::get_prg_bank_offset(uint16_t address) {
+int32_t Mapper4::get_prg_offset(uint16_t address) const {
+    if (address < 0x8000) return -1;
+    uint32_t offset = get_prg_bank_offset(address);
+    return offset < prg_size_ ? static_cast<int32_t>(offset) : -1;
+}
+
+int32_t Mapper4::get_chr_offset(uint16_t address) const {
+    if (address >= 0x2000) return -1;
+    uint32_t offset = get_chr_bank_offset(address);
+    return offset < chr_size_ ? static_cast<int32_t>(offset) : -1;
+}
+
+uint32_t Mapper4::get_prg_bank_offset(uint16_t address) const {
     uint32_t bank_number = 0;
     
     if (address < 0xA000) {
@@ -178,7 +190,7 @@ uint32_t Mapper4::get_prg_bank_offset(uint16_t address) {
     return (bank_number * 0x2000) + (address & 0x1FFF);
 }
 
-uint32_t Mapper4::get_chr_bank_offset(uint16_t address) {
+uint32_t Mapper4::get_chr_bank_offset(uint16_t address) const {
     uint32_t bank_number = 0;
     
     // Apply CHR A12 inversion
@@ -21,25 +21,29 @@ namespace nes {
  */
 class Mapper4 : public Mapper {
 public:
-    Mapper4(uint8_t* prg_rom, size_t prg_size,
-            uint8_t* chr_rom, size_t chr_size);
+    Mapper4(const uint8_t* prg_rom, size_t prg_size,
+            const uint8_t* chr_rom, size_t chr_size);
     ~Mapper4() override = default;
     
     uint8_t read(uint16_t address) override;
     void write(uint16_t address, uint8_t value) override;
     void reset() override;
     
+    int32_t get_prg_offset(uint16_t address) const override;
+    int32_t get_chr_offset(uint16_t address) const override;
+    
     MirrorMode get_mirroring() const { return mirror_mode_; }
     
     // PPU calls this on A12 rising edge (for scanline counter)
-    void notify_scanline();
-    bool irq_pending() const { return irq_flag_; }
+    bool uses_a12() const override { return true; }
+    void notify_a12_rise() override;
+    bool irq_pending() const override { return irq_flag_; }
     void clear_irq() { irq_flag_ = false; }
 
 private:
     // ROM pointers
-    uint8_t* prg_rom_;
-    uint8_t* chr_rom_;
+    const uint8_t* prg_rom_;
+    const uint8_t* chr_rom_;
     size_t prg_size_;
     size_t chr_size_;
     
@@ -78,8 +82,8 @@ private:
     uint8_t prg_ram_[0x2000];  // 8KB PRG RAM
     
     // Helper functions
-    uint32_t get_prg_bank_offset(uint16_t address);
-    uint32_t get_chr_bank_offset(uint16_t address);
+    uint32_t get_prg_bank_offset(uint16_t address) const;
+    uint32_t get_chr_bank_offset(uint16_t address) const;
 };
 
 } // namespace nes
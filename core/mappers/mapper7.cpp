@@ -3,8 +3,8 @@
 
 namespace nes {
 
-Mapper7::Mapper7(uint8_t* prg_rom, size_t prg_size,
-                 uint8_t* chr_rom, size_t chr_size)
+Mapper7::Mapper7(const uint8_t* prg_rom, size_t prg_size,
+                 const uint8_t* chr_rom, size_t chr_size)
     : prg_rom_(prg_rom), chr_rom_(chr_rom),
       prg_size_(prg_size), chr_size_(chr_size),
       prg_bank_(0), mirror_mode_(MirrorMode::SINGLE_SCREEN) {
@@ -49,4 +49,16 @@ void Mapper7::write(uint16_t address, uint8_t value) {
     }
 }
 
+int32_t Mapper7::get_prg_offset(uint16_t address) const {
+    if (address < 0x8000) return -1;
+    uint32_t offset = (prg_bank_ * 0x8000) + (address & 0x7FFF);
+    return offset < prg_size_ ? static_cast<int32_t>(offset) : -1;
+}
+
+int32_t Mapper7::get_chr_offset(uint16_t address) const {
+    // 8KB CHR RAM, không có banking
+    if (address >= 0x2000) return -1;
+    return static_cast<int32_t>(address);
+}
+
 } // namespace nes
@@ -1,4 +1,5 @@
 #include "memory/memory.h"
+#include "cpu/cpu.h"
 #include "ppu/ppu.h"
 #include "apu/apu.h"
 #include "input/input.h"
@@ -8,13 +9,18 @@
 namespace nes {
 
 Memory::Memory()
-    : ppu_(nullptr), apu_(nullptr), input_(nullptr), cartridge_(nullptr) {
+    : cpu_(nullptr), ppu_(nullptr), apu_(nullptr), input_(nullptr), cartridge_(nullptr),
+      profiler_(nullptr) {
     ram_.fill(0);
 }
 
 Memory::~Memory() {
 }
 
+void Memory::connect_cpu(CPU* cpu) {
+    cpu_ = cpu;
+}
+
 void Memory::connect_ppu(PPU* ppu) {
     ppu_ = ppu;
 }
@@ -41,6 +47,11 @@ uint8_t Memory::read(uint16_t address) {
         return ram_[address & 0x07FF];
     }
     
+    // Đếm truy cập thanh ghi PPU/APU (chỉ khi build với NES_PROFILER)
+    if (Profiler::ENABLED && profiler_ && address < 0x4018) {
+        profiler_->on_register_read(address);
+    }
+    
     // PPU Registers ($2000-$3FFF) - 8 bytes với mirrors
     if (address < 0x4000) {
         if (ppu_) {
@@ -90,6 +101,10 @@ void Memory::write(uint16_t address, uint8_t value) {
         return;
     }
     
+    if (Profiler::ENABLED && profiler_ && address < 0x4018) {
+        profiler_->on_register_write(address);
+    }
+    
     // PPU Registers ($2000-$3FFF)
     if (address < 0x4000) {
         if (ppu_) {
@@ -113,13 +128,7 @@ void Memory::write(uint16_t address, uint8_t value) {
     if (address < 0x4018) {
         // OAM DMA ($4014)
         if (address == 0x4014) {
-            if (ppu_) {
-                // DMA transfer từ CPU RAM sang PPU OAM
-                uint16_t dma_addr = value << 8;
-                for (int i = 0; i < 256; i++) {
-                    ppu_->write_oam_dma(i, read(dma_addr + i));
-                }
-            }
+            oam_dma(value);
             return;
         }
         
@@ -141,8 +150,66 @@ void Memory::write(uint16_t address, uint8_t value) {
     
     // Cartridge space ($4020-$FFFF)
     if (cartridge_) {
+        // Ghi mapper có thể đổi CHR bank / mirroring giữa scanline
+        if (address >= 0x8000 && ppu_) {
+            ppu_->cancel_bg_reuse();
+        }
+        // ... và PRG bank mà DMC đang đọc
+        if (address >= 0x8000 && apu_) {
+            apu_->invalidate_prg_pages();
+        }
         cartridge_->write(address, value);
     }
 }
 
+void Memory::oam_dma(uint8_t page) {
+    if (ppu_) {
+        // DMA transfer từ CPU memory sang PPU OAM.
+        // Page RAM / PRG ROM: nguồn liền một khối 256 bytes (bank nhỏ nhất 8KB) → copy thẳng
+        uint16_t dma_addr = page << 8;
+        const uint8_t* source = nullptr;
+        if (dma_addr < 0x2000) {
+            source = &ram_[dma_addr & 0x07FF];
+        } else if (dma_addr >= 0x8000 && cartridge_) {
+            int32_t offset = cartridge_->get_prg_offset(dma_addr);
+            if (offset >= 0 && static_cast<size_t>(offset) + 256 <= cartridge_->get_prg_size()) {
+                source = cartridge_->get_prg_rom() + offset;
+            }
+        }
+        
+        if (source) {
+            ppu_->write_oam_dma_page(source);
+        } else {
+            // Page I/O / PRG RAM: đọc qua handler từng byte
+            for (int i = 0; i < 256; i++) {
+                ppu_->write_oam_dma(i, read(dma_addr + i));
+            }
+        }
+    }
+    
+    // 1 cycle halt (+1 nếu DMA bắt đầu ở cycle lẻ) + 256 x (đọc + ghi)
+    if (cpu_) {
+        cpu_->add_stall_cycles(513 + ((cpu_->get_bus_cycle() + 1) & 1));
+    }
+}
+
+int32_t Memory::get_prg_offset(uint16_t address) const {
+    if (cartridge_) {
+        return cartridge_->get_prg_offset(address);
+    }
+    return -1;
+}
+
+const uint8_t* Memory::get_prg_page(uint16_t address) const {
+    if (!cartridge_ || address < 0x8000) {
+        return nullptr;
+    }
+    // Bank nhỏ nhất của các mapper là 8KB: cả page liền một khối trong PRG ROM
+    int32_t offset = cartridge_->get_prg_offset(address & 0xE000);
+    if (offset < 0 || static_cast<size_t>(offset) + 0x2000 > cartridge_->get_prg_size()) {
+        return nullptr;
+    }
+    return cartridge_->get_prg_rom() + offset;
+}
+
 } // namespace nes
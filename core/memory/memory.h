@@ -3,10 +3,12 @@
 
 #include <cstdint>
 #include <array>
+#include "cpu/profiler.h"
 
 namespace nes {
 
 // Forward declarations
+class CPU;
 class PPU;
 class APU;
 class Input;
@@ -32,6 +34,7 @@ public:
     /**
      * @brief Kết nối các component với memory bus
      */
+    void connect_cpu(CPU* cpu);
     void connect_ppu(PPU* ppu);
     void connect_apu(APU* apu);
     void connect_input(Input* input);
@@ -47,6 +50,23 @@ public:
      */
     void write(uint16_t address, uint8_t value);
     
+    /**
+     * @brief PRG ROM offset tại địa chỉ CPU (-1 nếu không phải ROM)
+     * Dùng bởi profiler / Code-Data Logger để phân biệt các bank
+     */
+    int32_t get_prg_offset(uint16_t address) const;
+    
+    /**
+     * @brief Con trỏ tới page PRG ROM 8KB đang map chứa address ($8000-$FFFF)
+     * @return nullptr nếu page không phải PRG ROM. Hết hiệu lực khi mapper đổi bank.
+     */
+    const uint8_t* get_prg_page(uint16_t address) const;
+    
+    /**
+     * @brief Kết nối profiler để đếm truy cập thanh ghi PPU/APU
+     */
+    void connect_profiler(Profiler* profiler) { profiler_ = profiler; }
+    
     /**
      * @brief Reset bộ nhớ
      */
@@ -57,10 +77,16 @@ private:
     std::array<uint8_t, 0x0800> ram_;
     
     // Connected components
+    CPU* cpu_;
     PPU* ppu_;
     APU* apu_;
     Input* input_;
     Cartridge* cartridge_;
+    
+    Profiler* profiler_;
+    
+    // OAM DMA ($4014): copy 256 bytes từ page CPU sang OAM, dừng CPU 513/514 cycles
+    void oam_dma(uint8_t page);
 };
 
 } // namespace nes
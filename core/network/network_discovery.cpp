@@ -5,20 +5,30 @@
 
 namespace nes {
 
-// Discovery Port
+// Discovery Port + multicast group (administratively scoped, stays inside the LAN)
 const int DISCOVERY_PORT = 6503;
+const char* const DISCOVERY_GROUP = "239.255.65.3";
+
+enum DiscoveryPacketType : uint8_t {
+    PACKET_ANNOUNCE = 1,  // Host presence / state
+    PACKET_QUERY = 2,     // "Hosts, announce yourselves" (sent by newcomers)
+    PACKET_BYE = 3        // Host stopped advertising
+};
 
 struct DiscoveryPacket {
     char header[4]; // "NESD"
+    uint8_t type;   // DiscoveryPacketType
     char device_id[33];
     char username[32];
     char game_name[32];
-    char rom_path[256];  // ROM path for validation
+    uint64_t rom_hash;   // ROM content hash, peers look it up in their own library
     uint16_t tcp_port;
 };
 
-NetworkDiscovery::NetworkDiscovery() 
-    : udp_socket_(INVALID_SOCKET), running_(false), advertising_(false) {
+NetworkDiscovery::NetworkDiscovery()
+    : udp_socket_(INVALID_SOCKET), running_(false), advertising_(false),
+      my_rom_hash_(0), my_tcp_port_(0), announce_pending_(false), announce_repeats_(0),
+      tick_(0), snapshot_(std::make_shared<const std::vector<Peer>>()) {
 }
 
 NetworkDiscovery::~NetworkDiscovery() {
@@ -45,14 +55,7 @@ bool NetworkDiscovery::init() {
         std::cerr << "Failed to enable SO_REUSEADDR" << std::endl;
     }
 
-    // Enable Broadcast
-    int broadcast = 1;
-    if (setsockopt(udp_socket_, SOL_SOCKET, SO_BROADCAST, (char*)&broadcast, sizeof(broadcast)) < 0) {
-        std::cerr << "Failed to enable broadcast" << std::endl;
-        return false;
-    }
-
-    // Bind to port to receive broadcasts
+    // Bind to port to receive group traffic
     sockaddr_in addr;
     addr.sin_family = AF_INET;
     addr.sin_port = htons(DISCOVERY_PORT);
@@ -60,30 +63,56 @@ bool NetworkDiscovery::init() {
 
     if (bind(udp_socket_, (sockaddr*)&addr, sizeof(addr)) < 0) {
         std::cerr << "Failed to bind UDP socket (Port " << DISCOVERY_PORT << " might be in use)" << std::endl;
-        // We can still send broadcasts even if bind fails, but we won't receive any.
+        // We can still send announcements even if bind fails, but we won't receive any.
         // For now, let's allow it but warn.
     }
 
+    // Join the multicast group. TTL 1: never leave the local subnet.
+    // Loopback on: other instances on this machine must see us too.
+    ip_mreq mreq;
+    inet_pton(AF_INET, DISCOVERY_GROUP, &mreq.imr_multiaddr);
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(udp_socket_, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char*)&mreq, sizeof(mreq)) < 0) {
+        std::cerr << "Failed to join discovery multicast group" << std::endl;
+    }
+    int ttl = 1;
+    setsockopt(udp_socket_, IPPROTO_IP, IP_MULTICAST_TTL, (char*)&ttl, sizeof(ttl));
+    int loop = 1;
+    setsockopt(udp_socket_, IPPROTO_IP, IP_MULTICAST_LOOP, (char*)&loop, sizeof(loop));
+
     running_ = true;
     receive_thread_ = std::thread(&NetworkDiscovery::receive_loop, this);
-    
+    timer_thread_ = std::thread(&NetworkDiscovery::timer_loop, this);
+
+    // Hosts already on the LAN answer right away instead of at their next keepalive
+    query();
+
     return true;
 }
 
 void NetworkDiscovery::shutdown() {
-    running_ = false;
-    advertising_ = false;
+    if (running_ && advertising_) {
+        stop_advertising();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        running_ = false;
+        advertising_ = false;
+    }
+    state_cv_.notify_all();
 
     if (udp_socket_ != INVALID_SOCKET) {
 #ifdef _WIN32
         closesocket(udp_socket_);
 #else
+        ::shutdown(udp_socket_, SHUT_RDWR);  // Wake recvfrom() in receive_loop
         close(udp_socket_);
 #endif
         udp_socket_ = INVALID_SOCKET;
     }
 
-    if (broadcast_thread_.joinable()) broadcast_thread_.join();
+    if (timer_thread_.joinable()) timer_thread_.join();
     if (receive_thread_.joinable()) receive_thread_.join();
 
 #ifdef _WIN32
@@ -91,48 +120,99 @@ void NetworkDiscovery::shutdown() {
 #endif
 }
 
-void NetworkDiscovery::start_advertising(const std::string& device_id, const std::string& username, 
-                                         const std::string& game_name, const std::string& rom_path, uint16_t tcp_port) {
-    if (advertising_) return;
+void NetworkDiscovery::start_advertising(const std::string& device_id, const std::string& username,
+                                         const std::string& game_name, uint64_t rom_hash, uint16_t tcp_port) {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        my_device_id_ = device_id;
+        my_username_ = username;
+        my_game_name_ = game_name;
+        my_rom_hash_ = rom_hash;
+        my_tcp_port_ = tcp_port;
 
-    my_device_id_ = device_id;
-    my_username_ = username;
-    my_game_name_ = game_name;
-    my_rom_path_ = rom_path;
-    my_tcp_port_ = tcp_port;
-    
-    advertising_ = true;
-    broadcast_thread_ = std::thread(&NetworkDiscovery::broadcast_loop, this);
+        advertising_ = true;
+        announce_pending_ = true;
+        announce_repeats_ = 1;
+    }
+    state_cv_.notify_all();
 }
 
 void NetworkDiscovery::stop_advertising() {
+    if (!advertising_) return;
     advertising_ = false;
-    if (broadcast_thread_.joinable()) broadcast_thread_.join();
+    send_packet(PACKET_BYE);
 }
 
-void NetworkDiscovery::broadcast_loop() {
-    while (running_ && advertising_) {
-        DiscoveryPacket packet;
-        memcpy(packet.header, "NESD", 4);
+void NetworkDiscovery::query() {
+    send_packet(PACKET_QUERY);
+}
+
+void NetworkDiscovery::request_announce() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (!advertising_) return;
+        announce_pending_ = true;
+    }
+    state_cv_.notify_all();
+}
+
+void NetworkDiscovery::send_packet(uint8_t type) {
+    DiscoveryPacket packet;
+    std::memset(&packet, 0, sizeof(packet));
+    memcpy(packet.header, "NESD", 4);
+    packet.type = type;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
         strncpy(packet.device_id, my_device_id_.c_str(), 32);
-        packet.device_id[32] = '\0';
         strncpy(packet.username, my_username_.c_str(), 31);
-        packet.username[31] = '\0';
         strncpy(packet.game_name, my_game_name_.c_str(), 31);
-        packet.game_name[31] = '\0';
-        strncpy(packet.rom_path, my_rom_path_.c_str(), 255);
-        packet.rom_path[255] = '\0';
+        packet.rom_hash = my_rom_hash_;
         packet.tcp_port = my_tcp_port_;
+    }
 
-        sockaddr_in dest_addr;
-        dest_addr.sin_family = AF_INET;
-        dest_addr.sin_port = htons(DISCOVERY_PORT);
-        dest_addr.sin_addr.s_addr = INADDR_BROADCAST;
+    sockaddr_in dest_addr;
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_port = htons(DISCOVERY_PORT);
+    inet_pton(AF_INET, DISCOVERY_GROUP, &dest_addr.sin_addr);
+
+    sendto(udp_socket_, (char*)&packet, sizeof(packet), 0, (sockaddr*)&dest_addr, sizeof(dest_addr));
+}
 
-        sendto(udp_socket_, (char*)&packet, sizeof(packet), 0, (sockaddr*)&dest_addr, sizeof(dest_addr));
+void NetworkDiscovery::timer_loop() {
+    using clock = std::chrono::steady_clock;
+    auto next_tick = clock::now() + std::chrono::seconds(1);
+    auto next_keepalive = clock::now();
 
-        // Broadcast every 1 second
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+    while (running_) {
+        bool announce = false;
+        bool tick = false;
+        {
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            state_cv_.wait_until(lock, next_tick, [this] { return !running_ || announce_pending_; });
+            if (!running_) break;
+
+            auto now = clock::now();
+            tick = now >= next_tick;
+            if (advertising_) {
+                // Changed state / query → now; otherwise only the follow-up repeat and keepalive
+                if (announce_pending_ || now >= next_keepalive) {
+                    announce = true;
+                } else if (tick && announce_repeats_ > 0) {
+                    announce = true;
+                    announce_repeats_--;
+                }
+            }
+            announce_pending_ = false;
+        }
+
+        if (announce) {
+            send_packet(PACKET_ANNOUNCE);
+            next_keepalive = clock::now() + std::chrono::seconds(KEEPALIVE_SECONDS);
+        }
+        if (tick) {
+            expire_tick();
+            next_tick += std::chrono::seconds(1);
+        }
     }
 }
 
@@ -143,63 +223,110 @@ void NetworkDiscovery::receive_loop() {
         socklen_t sender_len = sizeof(sender_addr);
 
         int received = recvfrom(udp_socket_, (char*)&packet, sizeof(packet), 0, (sockaddr*)&sender_addr, &sender_len);
-        
-        if (received == sizeof(DiscoveryPacket)) {
-            if (memcmp(packet.header, "NESD", 4) == 0) {
-                // Ignore our own packets
-                if (advertising_ && my_device_id_ == packet.device_id) continue;
-
-                std::lock_guard<std::mutex> lock(peers_mutex_);
-                
-                char ip_str[INET_ADDRSTRLEN];
-                inet_ntop(AF_INET, &(sender_addr.sin_addr), ip_str, INET_ADDRSTRLEN);
-                std::string ip(ip_str);
-
-                // Update existing or add new
-                bool found = false;
-                for (auto& peer : peers_) {
-                    if (peer.device_id == packet.device_id) {
-                        peer.ip = ip; // Update IP in case it changed
-                        peer.username = packet.username; // Update username
-                        peer.game_name = packet.game_name;
-                        peer.rom_path = packet.rom_path;
-                        peer.port = packet.tcp_port;
-                        peer.last_seen = std::chrono::steady_clock::now();
-                        found = true;
-                        break;
-                    }
-                }
+        if (received < 0) {
+            if (!running_) break;
+            continue;
+        }
+        if (received != sizeof(DiscoveryPacket) || memcmp(packet.header, "NESD", 4) != 0) {
+            continue;
+        }
+        packet.device_id[32] = '\0';
+        packet.username[31] = '\0';
+        packet.game_name[31] = '\0';
 
-                if (!found) {
-                    Peer new_peer;
-                    new_peer.device_id = packet.device_id;
-                    new_peer.ip = ip;
-                    new_peer.username = packet.username;
-                    new_peer.game_name = packet.game_name;
-                    new_peer.rom_path = packet.rom_path;
-                    new_peer.port = packet.tcp_port;
-                    new_peer.last_seen = std::chrono::steady_clock::now();
-                    peers_.push_back(new_peer);
-                }
-            }
+        if (packet.type == PACKET_QUERY) {
+            request_announce();
+            continue;
+        }
+
+        // Ignore our own packets
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            if (my_device_id_ == packet.device_id) continue;
+        }
+
+        if (packet.type == PACKET_ANNOUNCE) {
+            char ip_str[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &(sender_addr.sin_addr), ip_str, INET_ADDRSTRLEN);
+
+            Peer peer;
+            peer.device_id = packet.device_id;
+            peer.ip = ip_str;
+            peer.username = packet.username;
+            peer.game_name = packet.game_name;
+            peer.rom_hash = packet.rom_hash;
+            peer.port = packet.tcp_port;
+            touch_peer(std::move(peer));
+        } else if (packet.type == PACKET_BYE) {
+            remove_peer(packet.device_id);
         }
-        
-        // Small sleep to avoid CPU hogging if socket is non-blocking (it's blocking by default though)
-        // If blocking, recvfrom waits. But if socket closed, it returns error.
     }
 }
 
-std::vector<NetworkDiscovery::Peer> NetworkDiscovery::get_peers() {
+void NetworkDiscovery::touch_peer(Peer&& peer) {
     std::lock_guard<std::mutex> lock(peers_mutex_);
-    
-    // Remove stale peers (> 5 seconds)
-    auto now = std::chrono::steady_clock::now();
-    peers_.erase(std::remove_if(peers_.begin(), peers_.end(), 
-        [&](const Peer& p) {
-            return std::chrono::duration_cast<std::chrono::seconds>(now - p.last_seen).count() > 5;
-        }), peers_.end());
-
-    return peers_;
+
+    auto it = peers_.find(peer.device_id);
+    bool changed = it == peers_.end() ||
+                   it->second.peer.ip != peer.ip ||
+                   it->second.peer.username != peer.username ||
+                   it->second.peer.game_name != peer.game_name ||
+                   it->second.peer.rom_hash != peer.rom_hash ||
+                   it->second.peer.port != peer.port;
+
+    // Refresh: schedule in a new slot, the old slot entry is skipped when it fires
+    uint64_t expire = tick_ + PEER_TTL_SECONDS;
+    wheel_[expire % WHEEL_SLOTS].push_back(peer.device_id);
+
+    if (changed) {
+        std::string id = peer.device_id;
+        peers_[id] = {std::move(peer), expire};
+        publish();
+    } else {
+        it->second.expire_tick = expire;
+    }
+}
+
+void NetworkDiscovery::remove_peer(const std::string& device_id) {
+    std::lock_guard<std::mutex> lock(peers_mutex_);
+    if (peers_.erase(device_id) > 0) {
+        publish();
+    }
+}
+
+void NetworkDiscovery::expire_tick() {
+    std::lock_guard<std::mutex> lock(peers_mutex_);
+
+    tick_++;
+    std::vector<std::string>& slot = wheel_[tick_ % WHEEL_SLOTS];
+    bool changed = false;
+    for (const std::string& id : slot) {
+        auto it = peers_.find(id);
+        if (it != peers_.end() && it->second.expire_tick <= tick_) {
+            peers_.erase(it);
+            changed = true;
+        }
+    }
+    slot.clear();
+
+    if (changed) {
+        publish();
+    }
+}
+
+void NetworkDiscovery::publish() {
+    auto snapshot = std::make_shared<std::vector<Peer>>();
+    snapshot->reserve(peers_.size());
+    for (const auto& entry : peers_) {
+        snapshot->push_back(entry.second.peer);
+    }
+    // Stable order for the UI (unordered_map order changes on rehash)
+    std::sort(snapshot->begin(), snapshot->end(), [](const Peer& a, const Peer& b) {
+        return a.username != b.username ? a.username < b.username : a.device_id < b.device_id;
+    });
+
+    // Readers still holding the old list keep it alive; the last one frees it
+    std::atomic_store(&snapshot_, std::shared_ptr<const std::vector<Peer>>(std::move(snapshot)));
 }
 
 }
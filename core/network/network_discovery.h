@@ -6,7 +6,11 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <unordered_map>
 #include <chrono>
+#include <cstdint>
 
 #ifdef _WIN32
     #include <winsock2.h>
@@ -24,6 +28,11 @@
 
 namespace nes {
 
+// LAN discovery over UDP multicast.
+// Hosts announce only when their state changes (plus a slow keepalive) and answer
+// queries from newcomers; BYE removes a host from every peer list immediately.
+// The peer list is published as an immutable shared snapshot (std::atomic_load /
+// std::atomic_store), so the UI reads it every frame without locking or copying.
 class NetworkDiscovery {
 public:
     struct Peer {
@@ -31,9 +40,8 @@ public:
         std::string ip;
         std::string username;
         std::string game_name;
-        std::string rom_path;  // ROM path for validation
+        uint64_t rom_hash;     // ROM content hash (RomInfo::hash64), same on every machine
         uint16_t port;
-        std::chrono::steady_clock::time_point last_seen;
     };
 
     NetworkDiscovery();
@@ -42,36 +50,69 @@ public:
     bool init();
     void shutdown();
 
-    // Start broadcasting presence
-    void start_advertising(const std::string& device_id, const std::string& username, 
-                          const std::string& game_name, const std::string& rom_path, uint16_t tcp_port);
-    
-    // Stop broadcasting
+    // Start broadcasting presence (or update it: a changed state is re-announced at once)
+    void start_advertising(const std::string& device_id, const std::string& username,
+                          const std::string& game_name, uint64_t rom_hash, uint16_t tcp_port);
+
+    // Stop broadcasting (sends BYE)
     void stop_advertising();
 
-    // Get list of currently active peers
-    std::vector<Peer> get_peers();
+    // Ask every host on the LAN to announce itself now
+    void query();
+
+    // Current peers. The snapshot is never modified; holding the pointer keeps it
+    // (and any Peer reference into it) alive after the list is replaced.
+    std::shared_ptr<const std::vector<Peer>> get_peers() const {
+        return std::atomic_load(&snapshot_);
+    }
 
 private:
-    void broadcast_loop();
+    static constexpr int KEEPALIVE_SECONDS = 5;     // Announce even without changes
+    static constexpr int PEER_TTL_SECONDS = 12;     // Two missed keepalives + slack
+    static constexpr int WHEEL_SLOTS = 16;          // 1 second per slot, > PEER_TTL_SECONDS
+
+    struct PeerEntry {
+        Peer peer;
+        uint64_t expire_tick;   // Wheel tick at which the peer expires (refresh moves it)
+    };
+
+    void timer_loop();
     void receive_loop();
 
+    void send_packet(uint8_t type);
+    void request_announce();
+
+    // Peers (receive + timer thread only)
+    void touch_peer(Peer&& peer);
+    void remove_peer(const std::string& device_id);
+    void expire_tick();
+    void publish();                    // Caller holds peers_mutex_
+
     SOCKET udp_socket_;
-    std::thread broadcast_thread_;
+    std::thread timer_thread_;
     std::thread receive_thread_;
     std::atomic<bool> running_;
     std::atomic<bool> advertising_;
 
-    // Advertising data
+    // Advertising data (guarded by state_mutex_)
+    std::mutex state_mutex_;
+    std::condition_variable state_cv_;
     std::string my_device_id_;
     std::string my_username_;
     std::string my_game_name_;
-    std::string my_rom_path_;
+    uint64_t my_rom_hash_;
     uint16_t my_tcp_port_;
+    bool announce_pending_;            // State changed / query received
+    int announce_repeats_;             // Extra announces after a change (UDP may drop one)
 
-    // Peers list
+    // Peers + timer wheel (guarded by peers_mutex_, never touched by readers)
     std::mutex peers_mutex_;
-    std::vector<Peer> peers_;
+    std::unordered_map<std::string, PeerEntry> peers_;
+    std::vector<std::string> wheel_[WHEEL_SLOTS];
+    uint64_t tick_;
+
+    // Published snapshot (only accessed through std::atomic_load / std::atomic_store)
+    std::shared_ptr<const std::vector<Peer>> snapshot_;
 };
 
 }
@@ -47,6 +47,8 @@ void NetworkManager::disconnect() {
 #ifdef _WIN32
         closesocket(socket_);
 #else
+        // close() alone does not wake a recv() blocked in receive_thread_ on Linux
+        ::shutdown(socket_, SHUT_RDWR);
         close(socket_);
 #endif
         socket_ = INVALID_SOCKET;
@@ -56,6 +58,7 @@ void NetworkManager::disconnect() {
 #ifdef _WIN32
         closesocket(listen_socket_);
 #else
+        ::shutdown(listen_socket_, SHUT_RDWR);  // Wake accept() in host_thread_func
         close(listen_socket_);
 #endif
         listen_socket_ = INVALID_SOCKET;
@@ -70,9 +73,20 @@ void NetworkManager::disconnect() {
     input_queue_.clear();
 }
 
+void NetworkManager::set_local_rom(uint64_t rom_hash, const std::string& title) {
+    local_rom_hash_ = rom_hash;
+    local_rom_title_ = title;
+}
+
+std::string NetworkManager::get_remote_rom_title() {
+    std::lock_guard<std::mutex> lock(buffer_mutex_);
+    return remote_rom_title_;
+}
+
 bool NetworkManager::start_host(int port) {
     if (state_ != State::DISCONNECTED) return false;
     
+    rom_check_ = RomCheck::PENDING;
     state_ = State::HOSTING;
     is_host_ = true;
     running_ = true;
@@ -83,6 +97,7 @@ bool NetworkManager::start_host(int port) {
 bool NetworkManager::connect_to(const std::string& ip, int port) {
     if (state_ != State::DISCONNECTED) return false;
     
+    rom_check_ = RomCheck::PENDING;
     state_ = State::CONNECTING;
     is_host_ = false;
     running_ = true;
@@ -164,6 +179,7 @@ void NetworkManager::host_thread_func(int port) {
     int flag = 1;
     setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, (char*)&flag, sizeof(int));
 
+    send_hello();
     state_ = State::CONNECTED;
     std::cout << "Client connected!" << std::endl;
     
@@ -202,6 +218,7 @@ void NetworkManager::client_thread_func(std::string ip, int port) {
     int flag = 1;
     setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, (char*)&flag, sizeof(int));
 
+    send_hello();
     state_ = State::CONNECTED;
     std::cout << "Connected to host!" << std::endl;
 
@@ -259,10 +276,52 @@ void NetworkManager::receive_loop() {
             
             std::lock_guard<std::mutex> lock(buffer_mutex_);
             chat_queue_.push_back(std::string(chat_msg.message));
+        } else if (packet_type == 2) {
+            // ROM handshake
+            Hello hello;
+            if (!recv_exact((char*)&hello, sizeof(Hello))) {
+                std::cout << "Connection lost or closed." << std::endl;
+                state_ = State::DISCONNECTED;
+                return;
+            }
+            hello.title[sizeof(hello.title) - 1] = '\0';
+            {
+                std::lock_guard<std::mutex> lock(buffer_mutex_);
+                remote_rom_title_ = hello.title;
+            }
+            
+            bool match = std::memcmp(hello.magic, "NESH", 4) == 0 && hello.rom_hash == local_rom_hash_;
+            if (!match) {
+                std::cerr << "ROM mismatch: remote is running \"" << hello.title << "\"" << std::endl;
+            }
+            rom_check_ = match ? RomCheck::MATCH : RomCheck::MISMATCH;
         }
     }
 }
 
+void NetworkManager::send_hello() {
+    // Packet type header (2 = handshake)
+    uint8_t packet_type = 2;
+    send(socket_, (char*)&packet_type, 1, 0);
+    
+    Hello hello;
+    std::memset(&hello, 0, sizeof(hello));
+    std::memcpy(hello.magic, "NESH", 4);
+    hello.rom_hash = local_rom_hash_;
+    std::strncpy(hello.title, local_rom_title_.c_str(), sizeof(hello.title) - 1);
+    send(socket_, (char*)&hello, sizeof(Hello), 0);
+}
+
+bool NetworkManager::recv_exact(char* buffer, int size) {
+    int total_received = 0;
+    while (total_received < size) {
+        int recv_bytes = recv(socket_, buffer + total_received, size - total_received, 0);
+        if (recv_bytes <= 0) return false;
+        total_received += recv_bytes;
+    }
+    return true;
+}
+
 bool NetworkManager::send_input(uint32_t frame_id, uint8_t input) {
     return send_input(frame_id, input, 0);  // No checksum
 }
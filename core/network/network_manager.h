@@ -46,6 +46,20 @@ public:
     struct ChatMessage {
         char message[128];  // Max 127 characters + null terminator
     };
+    
+    // Session handshake, sent by both sides right after the TCP connection is up.
+    // Peers compare ROM content hashes (RomInfo::hash64), never file paths.
+    struct Hello {
+        char magic[4];      // "NESH"
+        uint64_t rom_hash;  // 64-bit content hash of the loaded ROM
+        char title[32];     // Short display title for error messages
+    };
+    
+    enum class RomCheck {
+        PENDING,   // Remote Hello not received yet
+        MATCH,     // Both sides run the same ROM
+        MISMATCH   // Different ROM: the session must not start
+    };
 
     NetworkManager();
     ~NetworkManager();
@@ -53,6 +67,12 @@ public:
     bool init();
     void shutdown();
 
+    // ROM announced in the handshake. Set before start_host / connect_to.
+    void set_local_rom(uint64_t rom_hash, const std::string& title);
+    
+    RomCheck get_rom_check() const { return rom_check_; }
+    std::string get_remote_rom_title();
+    
     // Host mode: Start listening for connections
     bool start_host(int port = 6502);
     
@@ -84,6 +104,8 @@ private:
     void host_thread_func(int port);
     void client_thread_func(std::string ip, int port);
     void receive_loop(); // Main loop for receiving data once connected
+    void send_hello();
+    bool recv_exact(char* buffer, int size);
 
     std::atomic<State> state_;
     std::atomic<bool> is_host_;
@@ -97,6 +119,12 @@ private:
     std::mutex buffer_mutex_;
     std::deque<Packet> input_queue_;
     std::deque<std::string> chat_queue_;  // Chat messages
+    
+    // ROM handshake
+    uint64_t local_rom_hash_ = 0;
+    std::string local_rom_title_;
+    std::string remote_rom_title_;        // Guarded by buffer_mutex_
+    std::atomic<RomCheck> rom_check_{RomCheck::PENDING};
 };
 
 }
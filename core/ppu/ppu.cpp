@@ -1,5 +1,6 @@
 #include "ppu/ppu.h"
 #include "cartridge/cartridge.h"
+#include "cartridge/code_data_logger.h"
 #include <cstring>
 
 
@@ -18,13 +19,17 @@ const uint32_t PPU::PALETTE_COLORS[64] = {
 };
 
 PPU::PPU() 
-    : scanline_(0), cycle_(0), frame_(0),
-      nmi_occurred_(false), cartridge_(nullptr),
-      oam_addr_(0), read_buffer_(0), data_bus_(0),
-      v_(0), t_(0), x_(0), w_(0),
-      sprite_count_(0), sprite_0_rendering_(false),
-      odd_frame_(false),
-      nt_latch_(0), at_latch_(0), at_palette_latch_(0), bg_lo_latch_(0), bg_hi_latch_(0) {
+    : oam_addr_(0), v_(0), t_(0), x_(0), w_(0),
+      read_buffer_(0), data_bus_(0),
+      sprite_rows_height_(8), sprite_rows_dirty_(true), sprite_limit_enabled_(false),
+      cartridge_(nullptr), cdl_(nullptr), cdl_chr_flag_(CDL_CHR_RENDERED),
+      scanline_(0), cycle_(0), frame_(0), nmi_occurred_(false),
+      nt_latch_(0), at_latch_(0), at_palette_latch_(0), bg_lo_latch_(0), bg_hi_latch_(0),
+      sprite_count_(0), loaded_sprite_count_(0), sprite_0_rendering_(false),
+      odd_frame_(false), a12_high_(false), a12_low_since_(0),
+      bg_reuse_enabled_(true), bg_reuse_line_(false), bg_record_line_(false),
+      bg_reuse_backoff_(0), bg_reuse_misses_(0), bg_frame_scroll_(0),
+      bg_line_start_v_(0), chr_write_gen_(0) {
     
     // Initialize registers
     std::memset(&ctrl_, 0, sizeof(ctrl_));
@@ -34,11 +39,22 @@ PPU::PPU()
     
     // Clear memory
     vram_.fill(0);
+    set_nametable_mirroring(MirrorMode::VERTICAL);
     oam_.fill(0);
     secondary_oam_.fill(0xFF);
     palette_.fill(0);
     framebuffer_.fill(0);
-    sprite_shifters_.fill({0, 0, 0, 0, 0, 0});
+    sprite_shifters_.fill({0xFF, 0, 0, 0xFF, 0, 0, false});
+    
+    set_output_surface(nullptr, 0, PixelFormat::RGBA32);
+    pixel_output_enabled_ = true;
+    
+    frame_indices_.fill(0xFF);
+    dirty_rows_.fill(~0ULL);
+    
+    bg_line_cache_.fill(0);
+    bg_line_valid_.fill(false);
+    nt_row_gen_.fill(0);
 }
 
 PPU::~PPU() {
@@ -49,6 +65,8 @@ void PPU::reset() {
     cycle_ = 0;
     frame_ = 0;
     nmi_occurred_ = false;
+    a12_high_ = false;
+    a12_low_since_ = 0;
     
     std::memset(&ctrl_, 0, sizeof(ctrl_));
     std::memset(&mask_, 0, sizeof(mask_));
@@ -60,10 +78,29 @@ void PPU::reset() {
     x_ = 0;
     w_ = 0;
     read_buffer_ = 0;
+    
+    // Frame đầu sau reset luôn vẽ lại toàn bộ (0xFF không phải palette index hợp lệ)
+    frame_indices_.fill(0xFF);
+    dirty_rows_.fill(~0ULL);
+    
+    bg_line_valid_.fill(false);
+    bg_reuse_line_ = false;
+    bg_record_line_ = false;
+    bg_reuse_backoff_ = 0;
+    bg_reuse_misses_ = 0;
+    bg_frame_scroll_ = 0;
 }
 
 void PPU::connect_cartridge(Cartridge* cartridge) {
     cartridge_ = cartridge;
+    bg_line_valid_.fill(false);
+    
+    // Mapper đổi mirroring → cập nhật trang nametable (không hỏi lại mỗi lần fetch)
+    if (cartridge_) {
+        cartridge_->set_mirroring_listener([this](MirrorMode mode) { set_nametable_mirroring(mode); });
+    } else {
+        set_nametable_mirroring(MirrorMode::VERTICAL);
+    }
 }
 
 bool PPU::step() {
@@ -72,6 +109,10 @@ bool PPU::step() {
     
     // Visible scanlines (0-239) and pre-render (261)
     if (scanline_ < 240 || scanline_ == 261) {
+        if (cycle_ == 1 && scanline_ < 240) {
+            begin_bg_line(rendering);
+        }
+        
         // Render pixel during visible cycles (MUST be before shifting)
         if (cycle_ >= 1 && cycle_ <= 256) {
             render_pixel();
@@ -79,69 +120,23 @@ bool PPU::step() {
 
         if (rendering) {
             // Background processing: Visible cycles and Pre-fetch (321-336)
-            if ((cycle_ >= 1 && cycle_ <= 256) || (cycle_ >= 321 && cycle_ <= 336)) {
-                // Shift every cycle
-                update_shifters();
-                
-                // 8-phase fetch cycle (simplified)
-                // Each tile takes 8 cycles to fetch
-                switch ((cycle_ - 1) % 8) {
-                    case 0:  // Cycle 1, 9, 17, 25... - Fetch nametable byte
-                        {
-                            uint16_t nt_addr = 0x2000 | (v_ & 0x0FFF);
-                            nt_latch_ = ppu_read(nt_addr);
-                        }
-                        break;
-                        
-                    case 2:  // Cycle 3, 11, 19, 27... - Fetch attribute byte
-                        {
-                            uint16_t attr_addr = 0x23C0 | (v_ & 0x0C00) | ((v_ >> 4) & 0x38) | ((v_ >> 2) & 0x07);
-                            at_latch_ = ppu_read(attr_addr);
-                            
-                            // Calculate attribute palette NOW, using current v_
-                            // This must be done before increment_scroll_x changes v_!
-                            uint8_t shift = ((v_ & 0x40) >> 4) | (v_ & 0x02);
-                            at_palette_latch_ = (at_latch_ >> shift) & 0x03;
-                        }
-                        break;
-                        
-                    case 4:  // Cycle 5, 13, 21, 29... - Fetch pattern low byte
-                        {
-                            uint16_t pat_addr = (ctrl_.bg_pattern ? 0x1000 : 0x0000) + (nt_latch_ * 16) + ((v_ >> 12) & 0x07);
-                            bg_lo_latch_ = ppu_read(pat_addr);
-                        }
-                        break;
-                        
-                    case 6:  // Cycle 7, 15, 23, 31... - Fetch pattern high byte
-                        {
-                            uint16_t pat_addr = (ctrl_.bg_pattern ? 0x1000 : 0x0000) + (nt_latch_ * 16) + ((v_ >> 12) & 0x07);
-                            bg_hi_latch_ = ppu_read(pat_addr + 8);
-                        }
-                        break;
-                        
-                    case 7:  // Cycle 8, 16, 24, 32... - Reload shifters and increment scroll
-                        {
-                            // Use pre-calculated attribute palette from cycle 3
-                            uint8_t pal = at_palette_latch_;
-                            
-                            // Load into shift registers
-                            bg_shifters_.pattern_lo = (bg_shifters_.pattern_lo & 0xFF00) | bg_lo_latch_;
-                            bg_shifters_.pattern_hi = (bg_shifters_.pattern_hi & 0xFF00) | bg_hi_latch_;
-                            bg_shifters_.attribute_lo = (bg_shifters_.attribute_lo & 0xFF00) | ((pal & 0x01) ? 0xFF : 0x00);
-                            bg_shifters_.attribute_hi = (bg_shifters_.attribute_hi & 0xFF00) | ((pal & 0x02) ? 0xFF : 0x00);
-                            
-                            // Increment scroll X
-                            increment_scroll_x();
-                        }
-                        break;
+            if (cycle_ >= 1 && cycle_ <= 256 && bg_reuse_line_) {
+                // Background của dòng lấy từ cache: bỏ qua fetch/shift, cuối dòng đặt
+                // v_ (32 lần increment_scroll_x) và shifters/latches như khi fetch thật
+                if (cycle_ == 256) {
+                    for (int i = 0; i < 32; i++) {
+                        increment_scroll_x();
+                    }
+                    restore_bg_line_end();
                 }
+            } else if ((cycle_ >= 1 && cycle_ <= 256) || (cycle_ >= 321 && cycle_ <= 336)) {
+                fetch_background_cycle();
             }
         }
         
         if (rendering) {
             // Sprite evaluation (moved to cycle 256 to avoid conflict with rendering)
             if (cycle_ == 256) {
-                secondary_oam_.fill(0xFF);
                 evaluate_sprites();
             }
             
@@ -163,6 +158,10 @@ bool PPU::step() {
                 copy_vertical_position();
             }
         }
+        
+        if (cycle_ == 256 && scanline_ < 240) {
+            end_bg_line();
+        }
     }
     
     // VBlank start (scanline 241, cycle 1)
@@ -227,8 +226,11 @@ uint8_t PPU::read_register(uint16_t address) {
             break;
             
         case 7: // $2007 PPUDATA
+            cancel_bg_reuse();  // Đọc $2007 làm thay đổi v_
             value = read_buffer_;
+            cdl_chr_flag_ = CDL_CHR_READ;
             read_buffer_ = ppu_read(v_);
+            cdl_chr_flag_ = CDL_CHR_RENDERED;
             if (v_ >= 0x3F00) {
                 value = read_buffer_;
                 read_buffer_ = ppu_read(v_ & 0x2FFF);
@@ -243,6 +245,7 @@ uint8_t PPU::read_register(uint16_t address) {
 }
 
 void PPU::write_register(uint16_t address, uint8_t value) {
+    cancel_bg_reuse();
     data_bus_ = value;
     
     switch (address & 0x0007) {
@@ -260,7 +263,7 @@ void PPU::write_register(uint16_t address, uint8_t value) {
             break;
             
         case 4: // $2004 OAMDATA
-            oam_[oam_addr_++] = value;
+            write_oam(oam_addr_++, value);
             break;
             
         case 5: // $2005 PPUSCROLL
@@ -296,6 +299,40 @@ void PPU::write_register(uint16_t address, uint8_t value) {
 
 void PPU::write_oam_dma(uint8_t index, uint8_t value) {
     oam_[index] = value;
+    sprite_rows_dirty_ = true;  // Build lại bucket một lần ở lần evaluate sau
+}
+
+void PPU::write_oam_dma_page(const uint8_t* data) {
+    std::memcpy(oam_.data(), data, oam_.size());
+    sprite_rows_dirty_ = true;
+}
+
+void PPU::write_oam(uint8_t index, uint8_t value) {
+    // Đổi Y của sprite: chuyển sprite sang bucket các dòng mới
+    if ((index & 0x03) == 0 && !sprite_rows_dirty_ && oam_[index] != value) {
+        set_sprite_rows(index >> 2, oam_[index], false);
+        set_sprite_rows(index >> 2, value, true);
+    }
+    oam_[index] = value;
+}
+
+void PPU::set_sprite_rows(int sprite, int y, bool present) {
+    uint64_t bit = 1ULL << sprite;
+    int end = y + sprite_rows_height_;
+    if (end > 240) end = 240;
+    for (int line = y; line < end; line++) {
+        if (present) sprite_rows_[line] |= bit;
+        else sprite_rows_[line] &= ~bit;
+    }
+}
+
+void PPU::rebuild_sprite_rows() {
+    sprite_rows_.fill(0);
+    sprite_rows_height_ = ctrl_.sprite_size ? 16 : 8;
+    for (int i = 0; i < 64; i++) {
+        set_sprite_rows(i, oam_[i * 4], true);
+    }
+    sprite_rows_dirty_ = false;
 }
 
 const uint8_t* PPU::get_framebuffer() const {
@@ -306,29 +343,14 @@ uint8_t PPU::ppu_read(uint16_t address) {
     address &= 0x3FFF;
     
     if (address < 0x2000) {
-        if (cartridge_) return cartridge_->read(address);
+        if (cartridge_) {
+            if (cartridge_->watches_a12()) clock_a12(address);
+            if (cdl_) cdl_->log_chr(cartridge_->get_chr_offset(address), cdl_chr_flag_);
+            return cartridge_->read(address);
+        }
     }
     else if (address < 0x3F00) {
-        address &= 0x0FFF;
-        if (!cartridge_) {
-            if (address >= 0x0800) address -= 0x0800;
-            return vram_[address & 0x07FF];
-        }
-        MirrorMode mirror = cartridge_->get_mirroring();
-        switch (mirror) {
-            case MirrorMode::HORIZONTAL:
-                {
-                    uint16_t masked = address & 0x03FF;
-                    if (address & 0x0800) masked |= 0x0400;
-                    return vram_[masked];
-                }
-            case MirrorMode::VERTICAL:
-                return vram_[address & 0x07FF];
-            case MirrorMode::SINGLE_SCREEN:
-                return vram_[address & 0x03FF];
-            default:
-                return vram_[address & 0x07FF];
-        }
+        return nt_pages_[(address >> 10) & 0x03][address & 0x03FF];
     }
     else if (address < 0x4000) {
         address &= 0x001F;
@@ -341,36 +363,39 @@ uint8_t PPU::ppu_read(uint16_t address) {
     return 0;
 }
 
+void PPU::set_nametable_mirroring(MirrorMode mode) {
+    // Trang vram_ cho $2000, $2400, $2800, $2C00
+    switch (mode) {
+        case MirrorMode::HORIZONTAL:
+            nt_page_index_ = {0, 0, 1, 1};
+            break;
+        case MirrorMode::SINGLE_SCREEN:
+            nt_page_index_ = {0, 0, 0, 0};
+            break;
+        case MirrorMode::FOUR_SCREEN:
+            nt_page_index_ = {0, 1, 2, 3};
+            break;
+        case MirrorMode::VERTICAL:
+        default:
+            nt_page_index_ = {0, 1, 0, 1};
+            break;
+    }
+    for (int i = 0; i < 4; i++) {
+        nt_pages_[i] = &vram_[nt_page_index_[i] << 10];
+    }
+}
+
 void PPU::ppu_write(uint16_t address, uint8_t value) {
     address &= 0x3FFF;
     if (address < 0x2000) {
         if (cartridge_) cartridge_->write(address, value);
+        chr_write_gen_++;
     }
     else if (address < 0x3F00) {
-        address &= 0x0FFF;
-        if (!cartridge_) {
-            if (address >= 0x0800) address -= 0x0800;
-            vram_[address & 0x07FF] = value;
-            return;
-        }
-        MirrorMode mirror = cartridge_->get_mirroring();
-        switch (mirror) {
-            case MirrorMode::HORIZONTAL:
-                {
-                    uint16_t masked = address & 0x03FF;
-                    if (address & 0x0800) masked |= 0x0400;
-                    vram_[masked] = value;
-                }
-                break;
-            case MirrorMode::VERTICAL:
-                vram_[address & 0x07FF] = value;
-                break;
-            case MirrorMode::SINGLE_SCREEN:
-                vram_[address & 0x03FF] = value;
-                break;
-            default:
-                vram_[address & 0x07FF] = value;
-                break;
+        uint16_t offset = nametable_offset(address & 0x0FFF);
+        if (vram_[offset] != value) {
+            vram_[offset] = value;
+            nt_row_gen_[offset >> 5]++;
         }
     }
     else if (address < 0x4000) {
@@ -394,14 +419,23 @@ void PPU::render_pixel() {
         // Check if we should hide leftmost 8 pixels
         bool hide_left = !mask_.show_bg_left && (cycle_ - 1) < 8;
         
-        if (!hide_left) {
-            uint16_t bit_mux = 0x8000 >> x_;
-            uint8_t p0 = (bg_shifters_.pattern_lo & bit_mux) ? 1 : 0;
-            uint8_t p1 = (bg_shifters_.pattern_hi & bit_mux) ? 1 : 0;
-            bg_pixel = (p1 << 1) | p0;
-            uint8_t a0 = (bg_shifters_.attribute_lo & bit_mux) ? 1 : 0;
-            uint8_t a1 = (bg_shifters_.attribute_hi & bit_mux) ? 1 : 0;
-            bg_palette = (a1 << 1) | a0;
+        uint8_t& cached = bg_line_cache_[scanline_ * 256 + (cycle_ - 1)];
+        if (bg_reuse_line_) {
+            bg_pixel = cached & 0x03;
+            bg_palette = cached >> 2;
+        } else {
+            if (!hide_left) {
+                uint16_t bit_mux = 0x8000 >> x_;
+                uint8_t p0 = (bg_shifters_.pattern_lo & bit_mux) ? 1 : 0;
+                uint8_t p1 = (bg_shifters_.pattern_hi & bit_mux) ? 1 : 0;
+                bg_pixel = (p1 << 1) | p0;
+                uint8_t a0 = (bg_shifters_.attribute_lo & bit_mux) ? 1 : 0;
+                uint8_t a1 = (bg_shifters_.attribute_hi & bit_mux) ? 1 : 0;
+                bg_palette = (a1 << 1) | a0;
+            }
+            if (bg_record_line_) {
+                cached = bg_pixel | (bg_palette << 2);
+            }
         }
     }
     
@@ -444,6 +478,9 @@ void PPU::render_pixel() {
         }
     }
     
+    // Frame không hiển thị: chỉ cần tác dụng phụ ở trên (sprite 0 hit)
+    if (!pixel_output_enabled_) return;
+    
     // Combine background and sprite pixels
     uint8_t final_pixel = 0;
     uint8_t final_palette = 0;
@@ -482,15 +519,246 @@ void PPU::render_pixel() {
         }
     }
     
-    uint32_t color = get_color_from_palette(final_palette, final_pixel);
-    int index = (scanline_ * 256 + (cycle_ - 1)) * 4;
+    uint8_t color_index = get_color_index(final_palette, final_pixel);
+    uint8_t& previous = frame_indices_[scanline_ * 256 + (cycle_ - 1)];
+    if (previous != color_index) {
+        previous = color_index;
+        dirty_rows_[scanline_ >> 6] |= 1ULL << (scanline_ & 63);
+    }
+    uint8_t* dst = output_pixels_ + scanline_ * output_pitch_ + (cycle_ - 1) * output_bpp_;
+    
+    // output_colors_ đã ở đúng thứ tự byte của surface
+    if (output_bpp_ == 4) {
+        std::memcpy(dst, &output_colors_[color_index], 4);
+    } else {
+        uint16_t color = static_cast<uint16_t>(output_colors_[color_index]);
+        std::memcpy(dst, &color, 2);
+    }
+}
+
+void PPU::set_output_surface(uint8_t* pixels, int pitch, PixelFormat format) {
+    if (pixels == nullptr) {
+        pixels = framebuffer_.data();
+        pitch = 256 * 4;
+        format = PixelFormat::RGBA32;
+    }
+    output_pixels_ = pixels;
+    output_pitch_ = pitch;
+    output_bpp_ = (format == PixelFormat::RGB565) ? 2 : 4;
     
-    // Store as RGBA (SDL_PIXELFORMAT_RGBA32)
-    // Palette is 0xAARRGGBB
-    framebuffer_[index + 0] = (color >> 16) & 0xFF; // R
-    framebuffer_[index + 1] = (color >> 8) & 0xFF;  // G
-    framebuffer_[index + 2] = color & 0xFF;         // B
-    framebuffer_[index + 3] = (color >> 24) & 0xFF; // A
+    // Palette là 0xAARRGGBB
+    for (int i = 0; i < 64; i++) {
+        uint32_t color = PALETTE_COLORS[i];
+        uint8_t r = (color >> 16) & 0xFF;
+        uint8_t g = (color >> 8) & 0xFF;
+        uint8_t b = color & 0xFF;
+        uint8_t a = (color >> 24) & 0xFF;
+        
+        if (format == PixelFormat::RGB565) {
+            output_colors_[i] = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+            continue;
+        }
+        
+        uint8_t bytes[4] = {r, g, b, a};
+        if (format == PixelFormat::BGRA32) {
+            bytes[0] = b;
+            bytes[2] = r;
+        }
+        std::memcpy(&output_colors_[i], bytes, 4);
+    }
+}
+
+void PPU::make_bg_line_key(BgLineKey& key) const {
+    std::memset(&key, 0, sizeof(key));
+    
+    // Trạng thái pipeline lúc bắt đầu dòng (sau prefetch 2 tile ở dòng trước)
+    key.v = v_;
+    key.fine_x = x_;
+    key.flags = (ctrl_.bg_pattern ? 0x01 : 0) | (mask_.show_bg_left ? 0x02 : 0);
+    key.shifters[0] = bg_shifters_.pattern_lo;
+    key.shifters[1] = bg_shifters_.pattern_hi;
+    key.shifters[2] = bg_shifters_.attribute_lo;
+    key.shifters[3] = bg_shifters_.attribute_hi;
+    key.latches[0] = nt_latch_;
+    key.latches[1] = at_latch_;
+    key.latches[2] = at_palette_latch_;
+    key.latches[3] = bg_lo_latch_;
+    key.latches[4] = bg_hi_latch_;
+    
+    // Một dòng chỉ đọc 1 hàng tile + 1 hàng attribute ở nametable hiện tại và nametable kề ngang
+    uint16_t coarse_y = (v_ >> 5) & 0x1F;
+    for (int side = 0; side < 2; side++) {
+        uint16_t nt_base = 0x2000 | ((v_ ^ (side << 10)) & 0x0C00);
+        uint16_t tile_row = nametable_offset(nt_base + coarse_y * 32) >> 5;
+        uint16_t attr_row = nametable_offset(nt_base + 0x3C0 + (coarse_y >> 2) * 8) >> 5;
+        key.nt_rows[side * 2] = tile_row;
+        key.nt_rows[side * 2 + 1] = attr_row;
+        key.nt_gens[side * 2] = nt_row_gen_[tile_row];
+        key.nt_gens[side * 2 + 1] = nt_row_gen_[attr_row];
+    }
+    
+    // CHR: bank đang map cho pattern table background + số lần ghi CHR RAM
+    uint16_t pattern_base = ctrl_.bg_pattern ? 0x1000 : 0x0000;
+    for (int i = 0; i < 4; i++) {
+        key.chr_offsets[i] = cartridge_->get_chr_offset(pattern_base + i * 0x400);
+    }
+    key.chr_write_gen = chr_write_gen_;
+}
+
+void PPU::update_bg_reuse_backoff() {
+    uint32_t scroll = v_ | (static_cast<uint32_t>(x_) << 16);
+    bool scrolled = scroll != bg_frame_scroll_;
+    bool missing = bg_reuse_misses_ > BG_REUSE_MAX_MISSES;
+    bg_frame_scroll_ = scroll;
+    bg_reuse_misses_ = 0;
+    
+    if (bg_reuse_backoff_ > 0) {
+        bg_reuse_backoff_--;
+    } else if (scrolled || missing) {
+        // Xoá cache: frame thử lại đầu tiên chỉ ghi, không bị tính là trượt key
+        bg_reuse_backoff_ = BG_REUSE_BACKOFF_FRAMES;
+        bg_line_valid_.fill(false);
+    }
+}
+
+void PPU::begin_bg_line(bool rendering) {
+    bg_reuse_line_ = false;
+    bg_record_line_ = false;
+    
+    if (scanline_ == 0) {
+        update_bg_reuse_backoff();
+    }
+    
+    // Chỉ cache khi fetch background không có tác dụng phụ: MMC3 đếm A12 từ fetch
+    // background khi background dùng pattern table $1000. CDL không cần tắt: key giữ
+    // CHR offsets nên dòng dùng lại fetch đúng các byte CHR đã log lúc ghi cache
+    if (!bg_reuse_enabled_ || bg_reuse_backoff_ > 0 || !rendering || !mask_.show_bg || !cartridge_ ||
+        (cartridge_->watches_a12() && ctrl_.bg_pattern)) {
+        bg_line_valid_[scanline_] = false;
+        return;
+    }
+    
+    BgLineKey key;
+    make_bg_line_key(key);
+    BgLineCache& line = bg_lines_[scanline_];
+    
+    if (bg_line_valid_[scanline_] && std::memcmp(&key, &line.key, sizeof(key)) == 0) {
+        bg_reuse_line_ = true;
+        bg_line_start_v_ = v_;
+        bg_line_start_shifters_ = bg_shifters_;
+    } else {
+        if (bg_line_valid_[scanline_]) {
+            bg_reuse_misses_++;
+        }
+        line.key = key;
+        bg_line_valid_[scanline_] = false;  // Chỉ hợp lệ khi render trọn dòng
+        bg_record_line_ = true;
+    }
+}
+
+void PPU::end_bg_line() {
+    if (bg_record_line_) {
+        BgLineCache& line = bg_lines_[scanline_];
+        line.end_shifters = bg_shifters_;
+        line.end_latches[0] = nt_latch_;
+        line.end_latches[1] = at_latch_;
+        line.end_latches[2] = at_palette_latch_;
+        line.end_latches[3] = bg_lo_latch_;
+        line.end_latches[4] = bg_hi_latch_;
+        bg_line_valid_[scanline_] = true;
+    }
+    bg_reuse_line_ = false;
+    bg_record_line_ = false;
+}
+
+void PPU::restore_bg_line_end() {
+    const BgLineCache& line = bg_lines_[scanline_];
+    bg_shifters_ = line.end_shifters;
+    nt_latch_ = line.end_latches[0];
+    at_latch_ = line.end_latches[1];
+    at_palette_latch_ = line.end_latches[2];
+    bg_lo_latch_ = line.end_latches[3];
+    bg_hi_latch_ = line.end_latches[4];
+}
+
+void PPU::cancel_bg_reuse() {
+    if (bg_record_line_) {
+        // Dòng đang ghi cache bị đổi giữa chừng: không dùng lại được
+        bg_record_line_ = false;
+        return;
+    }
+    if (!bg_reuse_line_) return;
+    
+    // Chạy lại fetch/shift của các cycle đã bỏ qua. Thay đổi chưa được áp dụng nên
+    // bộ nhớ vẫn như lúc bắt đầu dòng, v_ và shifters ra đúng như khi render bình thường
+    int resume_cycle = cycle_;
+    bg_reuse_line_ = false;
+    bg_line_valid_[scanline_] = false;
+    v_ = bg_line_start_v_;
+    bg_shifters_ = bg_line_start_shifters_;
+    for (int c = 1; c < resume_cycle && c <= 256; c++) {
+        cycle_ = c;
+        fetch_background_cycle();
+    }
+    cycle_ = resume_cycle;
+}
+
+void PPU::fetch_background_cycle() {
+    // Shift every cycle
+    update_shifters();
+    
+    // 8-phase fetch cycle (simplified)
+    // Each tile takes 8 cycles to fetch
+    switch ((cycle_ - 1) % 8) {
+        case 0:  // Cycle 1, 9, 17, 25... - Fetch nametable byte
+            {
+                uint16_t nt_addr = 0x2000 | (v_ & 0x0FFF);
+                nt_latch_ = ppu_read(nt_addr);
+            }
+            break;
+            
+        case 2:  // Cycle 3, 11, 19, 27... - Fetch attribute byte
+            {
+                uint16_t attr_addr = 0x23C0 | (v_ & 0x0C00) | ((v_ >> 4) & 0x38) | ((v_ >> 2) & 0x07);
+                at_latch_ = ppu_read(attr_addr);
+                
+                // Calculate attribute palette NOW, using current v_
+                // This must be done before increment_scroll_x changes v_!
+                uint8_t shift = ((v_ & 0x40) >> 4) | (v_ & 0x02);
+                at_palette_latch_ = (at_latch_ >> shift) & 0x03;
+            }
+            break;
+            
+        case 4:  // Cycle 5, 13, 21, 29... - Fetch pattern low byte
+            {
+                uint16_t pat_addr = (ctrl_.bg_pattern ? 0x1000 : 0x0000) + (nt_latch_ * 16) + ((v_ >> 12) & 0x07);
+                bg_lo_latch_ = ppu_read(pat_addr);
+            }
+            break;
+            
+        case 6:  // Cycle 7, 15, 23, 31... - Fetch pattern high byte
+            {
+                uint16_t pat_addr = (ctrl_.bg_pattern ? 0x1000 : 0x0000) + (nt_latch_ * 16) + ((v_ >> 12) & 0x07);
+                bg_hi_latch_ = ppu_read(pat_addr + 8);
+            }
+            break;
+            
+        case 7:  // Cycle 8, 16, 24, 32... - Reload shifters and increment scroll
+            {
+                // Use pre-calculated attribute palette from cycle 3
+                uint8_t pal = at_palette_latch_;
+                
+                // Load into shift registers
+                bg_shifters_.pattern_lo = (bg_shifters_.pattern_lo & 0xFF00) | bg_lo_latch_;
+                bg_shifters_.pattern_hi = (bg_shifters_.pattern_hi & 0xFF00) | bg_hi_latch_;
+                bg_shifters_.attribute_lo = (bg_shifters_.attribute_lo & 0xFF00) | ((pal & 0x01) ? 0xFF : 0x00);
+                bg_shifters_.attribute_hi = (bg_shifters_.attribute_hi & 0xFF00) | ((pal & 0x02) ? 0xFF : 0x00);
+                
+                // Increment scroll X
+                increment_scroll_x();
+            }
+            break;
+    }
 }
 
 void PPU::fetch_background_tile() {
@@ -529,39 +797,60 @@ void PPU::fetch_background_tile() {
 }
 
 void PPU::evaluate_sprites() {
-    if (scanline_ >= 240) return;
+    if (scanline_ >= 240) {
+        // Pre-render: không evaluate, load_sprites lấy các slot trống ($FF)
+        secondary_oam_.fill(0xFF);
+        return;
+    }
+    
+    if (sprite_rows_dirty_ || sprite_rows_height_ != (ctrl_.sprite_size ? 16 : 8)) {
+        rebuild_sprite_rows();
+    }
+    
     sprite_count_ = 0;
     sprite_0_rendering_ = false;
-    for (int i = 0; i < 64; i++) {
-        uint8_t y = oam_[i * 4 + 0];
-        int h = ctrl_.sprite_size ? 16 : 8;
-        int diff = scanline_ - y;
+    
+    // Đọc bucket của dòng thay vì quét cả 64 sprite
+    uint64_t in_range = sprite_rows_[scanline_];
+    for (int i = 0; in_range != 0; i++, in_range >>= 1) {
+        if (!(in_range & 1)) continue;
+        
+        secondary_oam_[sprite_count_ * 4 + 0] = oam_[i * 4 + 0];
+        secondary_oam_[sprite_count_ * 4 + 1] = oam_[i * 4 + 1];
+        secondary_oam_[sprite_count_ * 4 + 2] = oam_[i * 4 + 2];
+        secondary_oam_[sprite_count_ * 4 + 3] = oam_[i * 4 + 3];
+        if (i == 0) sprite_0_rendering_ = true;
+        sprite_count_++;
+        
+        if (sprite_limit_enabled_ && sprite_count_ == 8) {
+            // Đủ 8 sprite: phần cứng dừng copy, phần còn lại của OAM chỉ dò overflow
+            evaluate_sprite_overflow(i + 1);
+            break;
+        }
+    }
+}
+
+void PPU::evaluate_sprite_overflow(int n) {
+    // n = sprite ngay sau sprite thứ 8. Bug phần cứng: mỗi sprite không khớp làm tăng
+    // cả n lẫn m (byte trong sprite), nên tile/attr/X bị đọc nhầm như Y (không dùng bucket được)
+    int h = ctrl_.sprite_size ? 16 : 8;
+    int m = 0;
+    for (int i = n; i < 64; i++) {
+        int diff = scanline_ - oam_[i * 4 + m];
         if (diff >= 0 && diff < h) {
-            if (sprite_count_ < 64) {
-                // Hack: Don't set overflow flag to prevent game from hiding sprites
-                // if (sprite_count_ == 8) {
-                //    status_.sprite_overflow = 1;
-                // }
-                secondary_oam_[sprite_count_ * 4 + 0] = y;
-                secondary_oam_[sprite_count_ * 4 + 1] = oam_[i * 4 + 1];
-                secondary_oam_[sprite_count_ * 4 + 2] = oam_[i * 4 + 2];
-                secondary_oam_[sprite_count_ * 4 + 3] = oam_[i * 4 + 3];
-                if (i == 0) sprite_0_rendering_ = true;
-                sprite_count_++;
-            } else {
-                // Real hardware sets overflow here (at 8), but we do it above to allow "unlimited" sprites
-                // status_.sprite_overflow = 1; 
-                break;
-            }
+            status_.sprite_overflow = 1;
+            return;
         }
+        m = (m + 1) & 0x03;
     }
 }
 
 void PPU::load_sprites() {
-    // Clear all sprite shifters first to prevent garbage data
-    for (int i = 0; i < 64; i++) {
+    // Clear shifters còn lại từ dòng trước to prevent garbage data
+    for (int i = sprite_count_; i < loaded_sprite_count_; i++) {
         sprite_shifters_[i] = {0xFF, 0, 0, 0xFF, 0, 0, false};
     }
+    loaded_sprite_count_ = sprite_count_;
     
     // Load active sprites for current scanline
     for (int i = 0; i < sprite_count_ && i < 64; i++) {
@@ -602,6 +891,31 @@ void PPU::load_sprites() {
         
         sprite_shifters_[i] = {y, tile, attr, x, lo, hi, (i == 0 && sprite_0_rendering_)};
     }
+    
+    // Phần cứng luôn fetch đủ 8 sprite (slot trống dùng tile $FF):
+    // MMC3 dựa vào các fetch này để thấy A12 edge kể cả khi không có sprite
+    if (sprite_count_ < 8 && cartridge_ && cartridge_->watches_a12()) {
+        clock_a12(ctrl_.sprite_size ? 0x1000 : (ctrl_.sprite_pattern ? 0x1000 : 0x0000));
+    }
+}
+
+void PPU::clock_a12(uint16_t address) {
+    // Thời điểm hiện tại tính bằng PPU dot (chỉ cần tăng dần)
+    uint64_t now = frame_ * 341 * 262 + scanline_ * 341 + cycle_;
+    
+    if (address & 0x1000) {
+        // MMC3 lọc các rising edge khi A12 thấp chưa đủ ~3 CPU cycles (M2 filter):
+        // sprite 8x16 trộn 2 pattern table không được đếm thêm
+        if (!a12_high_ && now - a12_low_since_ >= 10) {
+            cartridge_->notify_a12_rise();
+        }
+        a12_high_ = true;
+    } else {
+        if (a12_high_) {
+            a12_low_since_ = now;
+        }
+        a12_high_ = false;
+    }
 }
 
 void PPU::increment_scroll_x() {
@@ -624,6 +938,10 @@ void PPU::copy_horizontal_position() { v_ = (v_ & 0xFBE0) | (t_ & 0x041F); }
 void PPU::copy_vertical_position() { v_ = (v_ & 0x841F) | (t_ & 0x7BE0); }
 
 uint32_t PPU::get_color_from_palette(uint8_t palette_index, uint8_t pixel) {
+    return PALETTE_COLORS[get_color_index(palette_index, pixel)];
+}
+
+uint8_t PPU::get_color_index(uint8_t palette_index, uint8_t pixel) {
     // Calculate palette address
     uint16_t address = 0x3F00 + (palette_index * 4) + pixel;
     
@@ -634,8 +952,7 @@ uint32_t PPU::get_color_from_palette(uint8_t palette_index, uint8_t pixel) {
         address = (palette_index >= 4) ? 0x3F10 : 0x3F00;
     }
     
-    uint8_t color_index = ppu_read(address) & 0x3F;
-    return PALETTE_COLORS[color_index];
+    return ppu_read(address) & 0x3F;
 }
 
 void PPU::update_shifters() {
@@ -8,6 +8,17 @@
 namespace nes {
 
 class Cartridge;
+class CodeDataLogger;
+enum class MirrorMode;
+
+/**
+ * @brief Định dạng pixel của output surface
+ */
+enum class PixelFormat {
+    RGBA32,  // Bytes R,G,B,A (SDL_PIXELFORMAT_RGBA32)
+    BGRA32,  // Bytes B,G,R,A (SDL_PIXELFORMAT_ARGB8888 trên little-endian)
+    RGB565   // 16-bit 5:6:5 (SDL_PIXELFORMAT_RGB565)
+};
 
 /**
  * @brief Picture Processing Unit - Đơn vị xử lý đồ họa NES
@@ -27,6 +38,16 @@ public:
     void reset();
     void connect_cartridge(Cartridge* cartridge);
     
+    /**
+     * @brief Kết nối Code/Data Logger để đánh dấu CHR đã dùng (nullptr = tắt)
+     * Xoá cache dòng background: dòng dùng lại không fetch CHR nên chỉ được bỏ qua
+     * khi lúc ghi cache nó đã được log.
+     */
+    void connect_cdl(CodeDataLogger* cdl) {
+        cdl_ = cdl;
+        bg_line_valid_.fill(false);
+    }
+    
     /**
      * @brief Thực thi 1 PPU cycle
      * PPU chạy 3x nhanh hơn CPU
@@ -46,10 +67,70 @@ public:
     void write_oam_dma(uint8_t index, uint8_t value);
     
     /**
-     * @brief Lấy framebuffer để render (256x240x4 RGBA)
+     * @brief Ghi cả 256 bytes OAM từ một page nguồn liền (OAM DMA nhanh)
+     */
+    void write_oam_dma_page(const uint8_t* data);
+    
+    /**
+     * @brief Lấy framebuffer nội bộ (256x240x4 RGBA)
+     * Chỉ được cập nhật khi không có output surface ngoài
      */
     const uint8_t* get_framebuffer() const;
     
+    /**
+     * @brief Ghi pixel trực tiếp vào surface ngoài (vd. bộ nhớ từ SDL_LockTexture)
+     * Màu được chuyển sang định dạng đích ngay lúc render, không cần copy sau frame.
+     * @param pixels Đầu surface 256x240 (nullptr = quay lại framebuffer nội bộ)
+     * @param pitch Số bytes mỗi dòng
+     */
+    void set_output_surface(uint8_t* pixels, int pitch, PixelFormat format);
+    
+    /**
+     * @brief Bật/tắt ghi pixel (mặc định bật)
+     * Khi tắt, PPU vẫn fetch/evaluate đầy đủ (sprite 0 hit, overflow, VBlank/NMI, A12
+     * như cũ) nhưng bỏ bước ghép màu, đổi palette và ghi surface. Dùng cho các frame
+     * không hiển thị (fast-forward, frame skip). Dirty rows của frame sau tính so với frame có ghi cuối cùng.
+     */
+    void set_pixel_output_enabled(bool enabled) { pixel_output_enabled_ = enabled; }
+    bool is_pixel_output_enabled() const { return pixel_output_enabled_; }
+    
+    /**
+     * @brief Giới hạn 8 sprite/scanline + cờ sprite overflow như phần cứng
+     * Mặc định tắt ("No Sprite Limit": vẽ đủ 64 sprite, không set overflow).
+     * Khi bật, overflow được tính cả bug chéo byte của phần cứng.
+     */
+    void set_sprite_limit_enabled(bool enabled) { sprite_limit_enabled_ = enabled; }
+    
+    /**
+     * @brief Mask 240 bit: bit y = scanline y có pixel bị ghi khác giá trị cũ
+     * kể từ lần clear_dirty_rows() trước. So sánh palette index từng pixel nên
+     * không phụ thuộc định dạng surface.
+     */
+    const std::array<uint64_t, 4>& get_dirty_rows() const { return dirty_rows_; }
+    void clear_dirty_rows() { dirty_rows_.fill(0); }
+    
+    /**
+     * @brief Có dòng nào thay đổi kể từ lần clear trước không
+     */
+    bool frame_changed() const {
+        return (dirty_rows_[0] | dirty_rows_[1] | dirty_rows_[2] | dirty_rows_[3]) != 0;
+    }
+    
+    /**
+     * @brief Bật/tắt dùng lại background của scanline không đổi (mặc định bật)
+     */
+    void set_bg_reuse_enabled(bool enabled) {
+        bg_reuse_enabled_ = enabled;
+        bg_reuse_backoff_ = 0;
+        bg_line_valid_.fill(false);
+    }
+    
+    /**
+     * @brief Gọi trước thay đổi từ ngoài PPU có thể ảnh hưởng background giữa
+     * scanline (ghi thanh ghi mapper). Dòng đang dùng cache quay về fetch bình thường.
+     */
+    void cancel_bg_reuse();
+    
     /**
      * @brief Check nếu cần trigger NMI
      */
@@ -127,19 +208,36 @@ private:
     // ==================
     
     // VRAM (2KB internal, mirrored)
-    std::array<uint8_t, 0x0800> vram_;  // $2000-$27FF (nametables)
+    // Nametable RAM: 2KB CIRAM + 2KB VRAM thêm của cartridge (chỉ dùng khi FOUR_SCREEN)
+    std::array<uint8_t, 0x1000> vram_;
+    
+    // 4 trang 1KB của $2000-$2FFF trỏ vào vram_, chỉ đổi khi mirroring đổi
+    std::array<uint8_t*, 4> nt_pages_;
+    std::array<uint8_t, 4> nt_page_index_;  // Trang 1KB trong vram_ của từng nametable
     
     // OAM (Object Attribute Memory) - 256 bytes
     // 64 sprites × 4 bytes each
     std::array<uint8_t, 256> oam_;
     std::array<uint8_t, 256> secondary_oam_;  // 64 sprites × 4 bytes (Increased from 8 for "No Sprite Limit" mode)
     
+    // Bucket sprite theo scanline: bit i của sprite_rows_[y] = sprite i nằm trong dòng y
+    // (theo thứ tự OAM nên đọc bit từ thấp lên là đúng thứ tự evaluate).
+    // $2004 cập nhật từng sprite, DMA chỉ đánh dấu để build lại một lần.
+    std::array<uint64_t, 240> sprite_rows_;
+    int sprite_rows_height_;   // Chiều cao sprite lúc build (8/16), đổi thì build lại
+    bool sprite_rows_dirty_;
+    bool sprite_limit_enabled_;
+    
     // Palette RAM - 32 bytes
     std::array<uint8_t, 32> palette_;
     
     // Connected cartridge (for CHR ROM/RAM)
     Cartridge* cartridge_;
     
+    // Code/Data Logger: flag gán cho CHR fetch (RENDERED, hoặc READ khi qua $2007)
+    CodeDataLogger* cdl_;
+    uint8_t cdl_chr_flag_;
+    
     // ==================
     // Rendering State
     // ==================
@@ -163,6 +261,17 @@ private:
     // Framebuffer (256×240×4 RGBA)
     std::array<uint8_t, 256 * 240 * 4> framebuffer_;
     
+    // Output surface (mặc định trỏ vào framebuffer_)
+    uint8_t* output_pixels_;
+    int output_pitch_;
+    int output_bpp_;
+    std::array<uint32_t, 64> output_colors_;  // PALETTE_COLORS đã đổi sang định dạng đích
+    bool pixel_output_enabled_;
+    
+    // Phát hiện dòng thay đổi: palette index lần ghi trước của mỗi pixel
+    std::array<uint8_t, 256 * 240> frame_indices_;
+    std::array<uint64_t, 4> dirty_rows_;
+    
     // ==================
     // Rendering helpers
     // ==================
@@ -197,6 +306,7 @@ private:
     
     std::array<Sprite, 64> sprite_shifters_;
     int sprite_count_;
+    int loaded_sprite_count_;  // Số shifter đã load ở dòng trước (cần xoá)
     bool sprite_0_rendering_;
     
     // ==================
@@ -205,6 +315,56 @@ private:
     
     bool odd_frame_;  // Track odd/even frames for cycle skip quirk
     
+    // ==================
+    // A12 edge detection (MMC3 scanline counter)
+    // ==================
+    
+    bool a12_high_;           // A12 của pattern fetch gần nhất
+    uint64_t a12_low_since_;  // Thời điểm (PPU dot) A12 xuống thấp
+    
+    // ==================
+    // Background line cache
+    // ==================
+    // Mỗi scanline lưu pixel background (bit 0-1) + palette (bit 2-3) của lần render
+    // trước cùng key gồm mọi input đã dùng. Key giống hệt thì lấy background từ cache,
+    // bỏ qua fetch/shift, chỉ còn composite sprite.
+    struct BgLineKey {
+        int32_t chr_offsets[4];   // Bank CHR của 4 x 1KB pattern table background
+        uint32_t chr_write_gen;
+        uint32_t nt_gens[4];      // Số lần ghi của các hàng nametable được đọc
+        uint16_t nt_rows[4];      // Hàng 32 bytes trong vram_ (tile + attribute, 2 nametable)
+        uint16_t shifters[4];
+        uint16_t v;
+        uint8_t latches[5];
+        uint8_t fine_x;
+        uint8_t flags;            // bg_pattern, show_bg_left
+    };
+    
+    struct BgLineCache {
+        BgLineKey key;
+        BackgroundShiftRegisters end_shifters;  // Trạng thái ở cycle 256 để khôi phục khi reuse
+        uint8_t end_latches[5];
+    };
+    
+    // Màn hình cuộn / key trượt liên tục: ghi + so sánh không bao giờ dùng lại được,
+    // nên tạm ngưng cache BG_REUSE_BACKOFF_FRAMES frame rồi thử lại
+    static constexpr int BG_REUSE_BACKOFF_FRAMES = 60;
+    static constexpr int BG_REUSE_MAX_MISSES = 120;  // Số dòng trượt key tối đa mỗi frame
+    
+    bool bg_reuse_enabled_;
+    bool bg_reuse_line_;    // Dòng hiện tại lấy background từ cache
+    bool bg_record_line_;   // Dòng hiện tại đang ghi vào cache
+    int bg_reuse_backoff_;  // Số frame còn lại không dùng cache
+    int bg_reuse_misses_;   // Dòng có cache hợp lệ nhưng key khác, trong frame hiện tại
+    uint32_t bg_frame_scroll_;  // v_ + fine X đầu frame trước
+    uint16_t bg_line_start_v_;
+    uint32_t chr_write_gen_;
+    BackgroundShiftRegisters bg_line_start_shifters_;
+    std::array<uint8_t, 256 * 240> bg_line_cache_;
+    std::array<BgLineCache, 240> bg_lines_;
+    std::array<bool, 240> bg_line_valid_;
+    std::array<uint32_t, 128> nt_row_gen_;  // Số lần ghi theo hàng 32 bytes của vram_
+    
     // Helper to check if rendering is enabled
     bool rendering_enabled() const {
         return mask_.show_bg || mask_.show_sprites;
@@ -216,15 +376,34 @@ private:
     
     // Memory access
     uint8_t ppu_read(uint16_t address);
+    uint16_t nametable_offset(uint16_t address) const {
+        return (nt_page_index_[(address >> 10) & 0x03] << 10) | (address & 0x03FF);
+    }
+    void set_nametable_mirroring(MirrorMode mode);
     void ppu_write(uint16_t address, uint8_t value);
     
+    // Theo dõi A12 trên pattern fetch, báo rising edge cho mapper
+    void clock_a12(uint16_t address);
+    
     // Rendering
     void render_pixel();
     void fetch_background_tile();
+    void fetch_background_cycle();
     void evaluate_sprites();
+    void evaluate_sprite_overflow(int n);
+    void write_oam(uint8_t index, uint8_t value);
+    void set_sprite_rows(int sprite, int y, bool present);
+    void rebuild_sprite_rows();
     void load_sprites();
     void update_shifters();
     
+    // Background line cache
+    void make_bg_line_key(BgLineKey& key) const;
+    void update_bg_reuse_backoff();  // Đầu frame: tạm ngưng cache khi cuộn / trượt key
+    void begin_bg_line(bool rendering);
+    void end_bg_line();
+    void restore_bg_line_end();
+    
     // Scrolling
     void increment_scroll_x();
     void increment_scroll_y();
@@ -233,6 +412,7 @@ private:
     
     // Palette
     uint32_t get_color_from_palette(uint8_t palette_index, uint8_t pixel);
+    uint8_t get_color_index(uint8_t palette_index, uint8_t pixel);
     
     // NES color palette (NTSC)
     static const uint32_t PALETTE_COLORS[64];
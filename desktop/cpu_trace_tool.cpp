@@ -0,0 +1,220 @@
+#include "../core/emulator.h"
+#include "../core/cpu/cpu_trace.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace nes;
+
+// Binary CPU trace tool:
+//   record <rom_file> <out.trace> [frames]   (cần build với NES_CPU_TRACE)
+//   diff   <a.trace> <b.trace> [context]     tìm lệnh đầu tiên khác nhau
+//   dump   <file.trace> [start] [count]      in record dạng text (giống nestest.log)
+
+// Số record đọc mỗi lần khi diff (24MB / file)
+static const size_t CHUNK_RECORDS = 1 << 20;
+
+static bool open_trace(const char* filename, FILE*& file) {
+    file = fopen(filename, "rb");
+    if (!file) {
+        std::cerr << "Cannot open " << filename << std::endl;
+        return false;
+    }
+
+    TraceFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        std::memcmp(header.magic, "NESTRACE", 8) != 0 ||
+        header.version != TRACE_FILE_VERSION ||
+        header.record_size != sizeof(TraceRecord)) {
+        std::cerr << filename << ": not a NESTRACE v" << TRACE_FILE_VERSION << " file" << std::endl;
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+static void print_record(uint64_t index, const TraceRecord& rec) {
+    // Format: "#12345  C000  4C  A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 21 CYC:7"
+    std::cout << "#" << std::dec << std::left << std::setw(10) << index << std::right
+              << std::hex << std::uppercase << std::setfill('0')
+              << std::setw(4) << rec.pc << "  "
+              << std::setw(2) << (int)rec.opcode << "  "
+              << "A:" << std::setw(2) << (int)rec.a << " "
+              << "X:" << std::setw(2) << (int)rec.x << " "
+              << "Y:" << std::setw(2) << (int)rec.y << " "
+              << "P:" << std::setw(2) << (int)rec.p << " "
+              << "SP:" << std::setw(2) << (int)rec.sp << " "
+              << std::dec << std::setfill(' ')
+              << "PPU:" << std::setw(3) << rec.scanline << "," << std::setw(3) << rec.dot << " "
+              << "CYC:" << rec.cycle << std::nouppercase << std::endl;
+}
+
+static void print_field_diff(const TraceRecord& a, const TraceRecord& b) {
+    std::cout << "Differs in:";
+    if (a.pc != b.pc) std::cout << " PC";
+    if (a.opcode != b.opcode) std::cout << " opcode";
+    if (a.a != b.a) std::cout << " A";
+    if (a.x != b.x) std::cout << " X";
+    if (a.y != b.y) std::cout << " Y";
+    if (a.p != b.p) std::cout << " P";
+    if (a.sp != b.sp) std::cout << " SP";
+    if (a.scanline != b.scanline || a.dot != b.dot) std::cout << " PPU";
+    if (a.cycle != b.cycle) std::cout << " CYC";
+    std::cout << std::endl;
+}
+
+static int cmd_record(const char* rom, const char* out, int frames) {
+#ifdef NES_CPU_TRACE
+    Emulator emu;
+    if (!emu.load_rom(rom)) {
+        std::cerr << "Failed to load ROM" << std::endl;
+        return 1;
+    }
+    emu.reset();
+
+    if (!emu.start_cpu_trace(out)) {
+        std::cerr << "Cannot create " << out << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        emu.run_frame();
+    }
+    emu.stop_cpu_trace();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Recorded " << emu.cpu_.total_instructions << " instructions ("
+              << frames << " frames) in "
+              << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+    return 0;
+#else
+    (void)rom; (void)out; (void)frames;
+    std::cerr << "Trace recorder not built in (configure with -DNES_CPU_TRACE=ON)" << std::endl;
+    return 1;
+#endif
+}
+
+static int cmd_diff(const char* file_a, const char* file_b, int context) {
+    FILE* fa = nullptr;
+    FILE* fb = nullptr;
+    if (!open_trace(file_a, fa)) return 1;
+    if (!open_trace(file_b, fb)) { fclose(fa); return 1; }
+
+    std::vector<TraceRecord> buf_a(CHUNK_RECORDS);
+    std::vector<TraceRecord> buf_b(CHUNK_RECORDS);
+
+    // Giữ lại vài record cuối của chunk trước để in context
+    std::vector<TraceRecord> history;
+    uint64_t base = 0;
+    int result = 0;
+
+    while (true) {
+        size_t na = fread(buf_a.data(), sizeof(TraceRecord), CHUNK_RECORDS, fa);
+        size_t nb = fread(buf_b.data(), sizeof(TraceRecord), CHUNK_RECORDS, fb);
+        size_t n = std::min(na, nb);
+
+        // So sánh cả khối trước, chỉ tìm từng record khi khối khác nhau
+        if (std::memcmp(buf_a.data(), buf_b.data(), n * sizeof(TraceRecord)) != 0) {
+            size_t i = 0;
+            while (std::memcmp(&buf_a[i], &buf_b[i], sizeof(TraceRecord)) == 0) {
+                i++;
+            }
+
+            std::cout << "First divergence at instruction " << (base + i) << std::endl << std::endl;
+
+            // Context: lấy từ chunk hiện tại, thiếu thì lấy từ history
+            size_t want = static_cast<size_t>(context);
+            size_t from_history = (i < want) ? std::min(want - i, history.size()) : 0;
+            for (size_t k = history.size() - from_history; k < history.size(); k++) {
+                print_record(base - (history.size() - k), history[k]);
+            }
+            for (size_t k = (i > want) ? i - want : 0; k < i; k++) {
+                print_record(base + k, buf_a[k]);
+            }
+
+            std::cout << std::endl << file_a << ":" << std::endl;
+            print_record(base + i, buf_a[i]);
+            std::cout << file_b << ":" << std::endl;
+            print_record(base + i, buf_b[i]);
+            print_field_diff(buf_a[i], buf_b[i]);
+            result = 1;
+            break;
+        }
+
+        base += n;
+
+        if (na != nb) {
+            std::cout << "Traces identical for " << base << " instructions, then "
+                      << (na < nb ? file_a : file_b) << " ends" << std::endl;
+            result = 1;
+            break;
+        }
+        if (n < CHUNK_RECORDS) {
+            std::cout << "Traces identical (" << base << " instructions)" << std::endl;
+            break;
+        }
+
+        if (context > 0) {
+            size_t keep = std::min(static_cast<size_t>(context), n);
+            history.assign(buf_a.begin() + (n - keep), buf_a.begin() + n);
+        }
+    }
+
+    fclose(fa);
+    fclose(fb);
+    return result;
+}
+
+static int cmd_dump(const char* filename, uint64_t start, uint64_t count) {
+    FILE* file = nullptr;
+    if (!open_trace(filename, file)) return 1;
+
+    // Seek theo từng bước < 2GB (long chỉ 32-bit trên Windows)
+    uint64_t skip = start * sizeof(TraceRecord);
+    while (skip > 0) {
+        long step = static_cast<long>(std::min<uint64_t>(skip, 1u << 30));
+        if (fseek(file, step, SEEK_CUR) != 0) {
+            fclose(file);
+            return 1;
+        }
+        skip -= step;
+    }
+
+    TraceRecord rec;
+    for (uint64_t i = 0; i < count && fread(&rec, sizeof(rec), 1, file) == 1; i++) {
+        print_record(start + i, rec);
+    }
+
+    fclose(file);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 4 && std::strcmp(argv[1], "record") == 0) {
+        int frames = (argc >= 5) ? std::atoi(argv[4]) : 600;
+        return cmd_record(argv[2], argv[3], frames);
+    }
+    if (argc >= 4 && std::strcmp(argv[1], "diff") == 0) {
+        int context = (argc >= 5) ? std::atoi(argv[4]) : 5;
+        return cmd_diff(argv[2], argv[3], context);
+    }
+    if (argc >= 3 && std::strcmp(argv[1], "dump") == 0) {
+        uint64_t start = (argc >= 4) ? std::strtoull(argv[3], nullptr, 10) : 0;
+        uint64_t count = (argc >= 5) ? std::strtoull(argv[4], nullptr, 10) : 100;
+        return cmd_dump(argv[2], start, count);
+    }
+
+    std::cerr << "Usage:" << std::endl
+              << "  " << argv[0] << " record <rom_file> <out.trace> [frames]" << std::endl
+              << "  " << argv[0] << " diff <a.trace> <b.trace> [context]" << std::endl
+              << "  " << argv[0] << " dump <file.trace> [start] [count]" << std::endl;
+    return 1;
+}
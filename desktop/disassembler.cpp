@@ -111,22 +111,33 @@ static const OpcodeEntry OPCODE_TABLE[256] = {
 };
 
 DisassembledInstruction Disassembler::disassemble(uint16_t pc, Memory* memory) {
+    uint8_t bytes[3] = {0, 0, 0};
+    
+    bytes[0] = memory->read(pc);
+    int length = OPCODE_TABLE[bytes[0]].length;
+    
+    // Read operand bytes
+    if (length >= 2) {
+        bytes[1] = memory->read(pc + 1);
+    }
+    if (length == 3) {
+        bytes[2] = memory->read(pc + 2);
+    }
+    
+    return disassemble(pc, bytes);
+}
+
+DisassembledInstruction Disassembler::disassemble(uint16_t pc, const uint8_t bytes[3]) {
     DisassembledInstruction inst;
     
-    inst.opcode = memory->read(pc);
+    inst.opcode = bytes[0];
     const OpcodeEntry& entry = OPCODE_TABLE[inst.opcode];
     
     inst.length = entry.length;
     inst.mnemonic = entry.name;
-    inst.bytes[0] = inst.opcode;
-    
-    // Read operand bytes
-    if (inst.length >= 2) {
-        inst.bytes[1] = memory->read(pc + 1);
-    }
-    if (inst.length == 3) {
-        inst.bytes[2] = memory->read(pc + 2);
-    }
+    inst.bytes[0] = bytes[0];
+    inst.bytes[1] = bytes[1];
+    inst.bytes[2] = bytes[2];
     
     // Format operand based on addressing mode
     std::string mode = entry.addr_mode;
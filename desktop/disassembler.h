@@ -20,6 +20,9 @@ namespace nes {
     class Disassembler {
     public:
         static DisassembledInstruction disassemble(uint16_t pc, Memory* memory);
+        
+        // Disassemble từ raw bytes (vd. PRG ROM của bank không đang được map)
+        static DisassembledInstruction disassemble(uint16_t pc, const uint8_t bytes[3]);
     };
 }
 
@@ -0,0 +1,161 @@
+#include "../core/emulator.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <cstdlib>
+
+using namespace nes;
+
+// Headless frame skip check: chạy cùng ROM 2 lần, lần đầu render mọi frame,
+// lần sau tắt pixel output theo pattern skip. Trạng thái game (RAM, CPU, số cycles)
+// phải giống hệt nhau sau từng frame, nếu không frame skip đã làm đổi logic game
+// (sprite 0 hit, sprite overflow, VBlank/NMI...).
+// Không truyền ROM: dùng ROM NROM dựng sẵn bên dưới (chạy trong ctest, exit code 0 = OK).
+
+// Chương trình test ($C000, PRG 16KB mirror ở $8000):
+// nametable toàn tile đặc, sprite 0 đè lên; main loop đếm số vòng chờ sprite 0 hit,
+// NMI đổi scroll X và X của sprite 0 mỗi frame. RAM phụ thuộc trực tiếp vào thời điểm
+// hit và $2002, nên chỉ cần frame skip làm lệch 1 pixel là RAM khác.
+static const uint8_t BUILTIN_PROGRAM[] = {
+    0x78, 0xD8, 0xA2, 0xFF, 0x9A,              // C000: SEI / CLD / LDX #$FF / TXS
+    0x2C, 0x02, 0x20, 0x10, 0xFB,              // C005: BIT $2002 / BPL -5  (VBlank 1)
+    0x2C, 0x02, 0x20, 0x10, 0xFB,              // C00A: BIT $2002 / BPL -5  (VBlank 2)
+    0xA9, 0x3F, 0x8D, 0x06, 0x20,              // C00F: palette $3F00 = $0F, $30
+    0xA9, 0x00, 0x8D, 0x06, 0x20,
+    0xA9, 0x0F, 0x8D, 0x07, 0x20,
+    0xA9, 0x30, 0x8D, 0x07, 0x20,
+    0xA9, 0x20, 0x8D, 0x06, 0x20,              // C023: $2000-$23FF = tile 1
+    0xA9, 0x00, 0x8D, 0x06, 0x20,
+    0xA0, 0x04, 0xA2, 0x00, 0xA9, 0x01,        // C02D: LDY #4 / LDX #0 / LDA #1
+    0x8D, 0x07, 0x20, 0xCA, 0xD0, 0xFA,        // C033: STA $2007 / DEX / BNE C033
+    0x88, 0xD0, 0xF7,                          // C039: DEY / BNE C033
+    0xA9, 0x00, 0x8D, 0x03, 0x20,              // C03C: sprite 0 = Y 100, tile 1, X 100
+    0xA9, 0x64, 0x8D, 0x04, 0x20,
+    0xA9, 0x01, 0x8D, 0x04, 0x20,
+    0xA9, 0x00, 0x8D, 0x04, 0x20,
+    0xA9, 0x64, 0x8D, 0x04, 0x20,
+    0xA9, 0x00, 0x8D, 0x05, 0x20, 0x8D, 0x05, 0x20,  // C055: scroll 0, 0
+    0xA9, 0x80, 0x8D, 0x00, 0x20,              // C05D: NMI on
+    0xA9, 0x1E, 0x8D, 0x01, 0x20,              // C062: BG + sprites on
+    0x2C, 0x02, 0x20, 0x70, 0xFB,              // C067: main: BIT $2002 / BVS C067 (chờ hit clear)
+    0xE6, 0x02, 0x2C, 0x02, 0x20, 0x50, 0xF9,  // C06C: INC $02 / BIT $2002 / BVC C06C
+    0xE6, 0x00, 0xAD, 0x02, 0x20, 0x85, 0x01,  // C073: INC $00 / LDA $2002 / STA $01
+    0x4C, 0x67, 0xC0,                          // C07A: JMP main
+    0xE6, 0x03, 0x48, 0xAD, 0x02, 0x20,        // C07D: nmi: INC $03 / PHA / LDA $2002
+    0xA5, 0x03, 0x8D, 0x05, 0x20,              // C083: scroll X = $03
+    0xA9, 0x00, 0x8D, 0x05, 0x20,
+    0xA9, 0x03, 0x8D, 0x03, 0x20,              // C08D: sprite 0 X = $03
+    0xA5, 0x03, 0x8D, 0x04, 0x20,
+    0x68, 0x40                                 // C097: PLA / RTI
+};
+
+static const uint16_t BUILTIN_NMI = 0xC07D;
+static const uint16_t BUILTIN_RESET = 0xC000;
+static const uint16_t BUILTIN_IRQ = 0xC098;  // RTI
+
+static bool write_builtin_rom(const std::string& path) {
+    std::vector<uint8_t> rom(16 + 0x4000 + 0x2000, 0);
+    const uint8_t header[8] = {'N', 'E', 'S', 0x1A, 1, 1, 0, 0};  // 16KB PRG, 8KB CHR, mapper 0
+    std::copy(header, header + 8, rom.begin());
+
+    uint8_t* prg = &rom[16];
+    std::copy(BUILTIN_PROGRAM, BUILTIN_PROGRAM + sizeof(BUILTIN_PROGRAM), prg);
+    const uint16_t vectors[3] = {BUILTIN_NMI, BUILTIN_RESET, BUILTIN_IRQ};
+    for (int i = 0; i < 3; i++) {
+        prg[0x3FFA + i * 2] = vectors[i] & 0xFF;
+        prg[0x3FFB + i * 2] = vectors[i] >> 8;
+    }
+
+    // Tile 1: màu 1 ở mọi pixel (plane 0 = $FF)
+    uint8_t* chr = &rom[16 + 0x4000];
+    std::fill(chr + 16, chr + 24, 0xFF);
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(rom.data()), rom.size());
+    return static_cast<bool>(file);
+}
+
+static uint64_t hash_ram(Emulator& emu) {
+    // FNV-1a trên internal RAM
+    uint64_t h = 1469598103934665603ULL;
+    for (uint16_t addr = 0; addr < 0x0800; addr++) {
+        h ^= emu.memory_.read(addr);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Pattern skip: 0 = không skip, 1 = skip xen kẽ, 2..n = render 1 frame mỗi n frame,
+// -1 = giả ngẫu nhiên (giống frame skip tự động khi máy chậm không đều)
+static bool should_skip(int pattern, int frame, uint32_t& rng) {
+    if (pattern == 0) return false;
+    if (pattern < 0) {
+        rng = rng * 1664525u + 1013904223u;
+        return (rng >> 30) != 0;  // ~75% frame bị skip
+    }
+    return (frame % (pattern + 1)) != 0;
+}
+
+int main(int argc, char* argv[]) {
+    // frame_skip_check [rom_file|-] [frames] [pattern]   ("-" = ROM dựng sẵn)
+    bool builtin = argc < 2 || std::string(argv[1]) == "-";
+    int frames = (argc >= 3) ? std::atoi(argv[2]) : 600;
+    int pattern = (argc >= 4) ? std::atoi(argv[3]) : -1;
+    // Mỗi pattern một file: ctest -j chạy các pattern song song trong cùng thư mục
+    std::string rom_path = builtin ? "frame_skip_check_" + std::to_string(pattern) + ".nes" : argv[1];
+
+    if (builtin && !write_builtin_rom(rom_path)) {
+        std::cerr << "Failed to write " << rom_path << std::endl;
+        return 1;
+    }
+
+    Emulator reference, skipped;
+    if (!reference.load_rom(rom_path) || !skipped.load_rom(rom_path)) {
+        std::cerr << "Failed to load ROM" << std::endl;
+        return 1;
+    }
+    reference.reset();
+    skipped.reset();
+
+    std::cout << "=== Frame Skip Check (" << frames << " frames, pattern " << pattern << ") ===" << std::endl;
+
+    uint32_t rng = 12345;
+    int skipped_frames = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        bool skip = should_skip(pattern, frame, rng);
+        skipped_frames += skip ? 1 : 0;
+
+        reference.run_frame();
+        skipped.set_pixel_output_enabled(!skip);
+        skipped.run_frame();
+        skipped.set_pixel_output_enabled(true);
+
+        uint64_t ref_hash = hash_ram(reference);
+        uint64_t skip_hash = hash_ram(skipped);
+        if (ref_hash != skip_hash ||
+            reference.cpu_.total_cycles != skipped.cpu_.total_cycles ||
+            reference.cpu_.PC != skipped.cpu_.PC ||
+            reference.cpu_.A != skipped.cpu_.A ||
+            reference.cpu_.X != skipped.cpu_.X ||
+            reference.cpu_.Y != skipped.cpu_.Y ||
+            reference.cpu_.P != skipped.cpu_.P) {
+            std::cerr << "MISMATCH at frame " << frame << (skip ? " (skipped)" : " (rendered)")
+                      << std::hex << std::setfill('0')
+                      << ": RAM " << std::setw(16) << ref_hash << " vs " << std::setw(16) << skip_hash
+                      << ", PC $" << std::setw(4) << reference.cpu_.PC << " vs $" << std::setw(4) << skipped.cpu_.PC
+                      << std::dec << std::endl;
+            return 1;
+        }
+    }
+
+    // ROM dựng sẵn phải thật sự chạy tới sprite 0 hit, nếu không check trên là vô nghĩa
+    if (builtin && reference.memory_.read(0x0000) == 0) {
+        std::cerr << "Built-in ROM never reached sprite 0 hit" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Skipped " << skipped_frames << " / " << frames << " frames" << std::endl;
+    std::cout << "State match: OK" << std::endl;
+    return 0;
+}
@@ -19,6 +19,7 @@
 #include <sstream>
 #include <filesystem>
 #include "../core/emulator.h"
+#include "../core/apu/audio_ring.h"
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "stb_truetype.h"
@@ -74,11 +75,15 @@ const int SCALE = 3; // 3x scale = 768x720
 #include "systems/HomeScene.h"
 #include "systems/LobbyScene.h"
 #include "systems/SettingsScene.h"
+#include "systems/EmuThread.h"
 
 // --- Global Replay Instances ---
 Recorder recorder;
 ReplayPlayer replay_player;
 
+// --- ROM Library (định danh ROM theo nội dung: replay, netplay) ---
+nes::RomLibrary rom_library;
+
 
 
 // --- Font System (stb_truetype) ---
@@ -94,6 +99,53 @@ FontSystem font_title;
 
 
 
+// --- Audio Output ---
+// Core push samples vào ring sau mỗi frame, SDL callback kéo ra theo nhịp sound card.
+// Target ~2 frames (1470 samples @ 44100 Hz): đủ đệm cho jitter mà latency vẫn thấp.
+// Tính lại theo rate thật của device sau khi mở.
+const size_t AUDIO_TARGET_FILL = 1470;
+AudioRing audio_ring(8192);
+AudioRateControl audio_rate(AUDIO_TARGET_FILL);
+
+void audio_callback(void* userdata, Uint8* stream, int len) {
+    AudioRing* ring = static_cast<AudioRing*>(userdata);
+    float* out = reinterpret_cast<float*>(stream);
+    size_t count = static_cast<size_t>(len) / sizeof(float);
+    size_t got = ring->pop(out, count);
+    // Underrun: lặp lại sample cuối thay vì chèn 0 để tránh tiếng "tách"
+    float last = (got > 0) ? out[got - 1] : 0.0f;
+    for (size_t i = got; i < count; i++) out[i] = last;
+}
+
+// --- Video Output ---
+// Frame đang hiển thị (trong định dạng của texture), dùng cho Snapshot
+const uint8_t* presented_frame = nullptr;
+Uint32 presented_format = SDL_PIXELFORMAT_RGBA32;
+
+// Chọn định dạng texture mà renderer hỗ trợ native để PPU ghi đúng định dạng đó,
+// upload chỉ còn là memcpy (SDL không phải convert)
+Uint32 choose_texture_format(SDL_Renderer* renderer, PixelFormat& format) {
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0) {
+        for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+            Uint32 f = info.texture_formats[i];
+            if (f == SDL_PIXELFORMAT_BGRA32) { format = PixelFormat::BGRA32; return f; }
+            if (f == SDL_PIXELFORMAT_RGBA32) { format = PixelFormat::RGBA32; return f; }
+            if (f == SDL_PIXELFORMAT_RGB565) { format = PixelFormat::RGB565; return f; }
+        }
+    }
+    format = PixelFormat::RGBA32;
+    return SDL_PIXELFORMAT_RGBA32;
+}
+
+// Bỏ audio đang chờ (pause / đổi game). Khoá device để callback không pop cùng lúc.
+void clear_audio(SDL_AudioDeviceID device) {
+    if (device == 0) return;
+    SDL_LockAudioDevice(device);
+    audio_ring.clear();
+    SDL_UnlockAudioDevice(device);
+}
+
 // Calculate simple checksum for desync detection
 uint32_t calculate_game_checksum(Emulator& emu) {
     uint32_t checksum = 0;
@@ -119,29 +171,8 @@ uint32_t calculate_game_checksum(Emulator& emu) {
     return checksum;
 }
 
-// Input Handling
-void handle_input(Emulator& emu, const Uint8* keys, const VirtualJoystick& joystick, const std::vector<VirtualButton>& buttons, const std::vector<SDL_GameController*>& controllers) {
-    // Check if we're playing back a replay
-    uint8_t p1_buttons = 0;
-    uint8_t p2_buttons = 0;
-    
-    if (replay_player.is_playing) {
-        // Use replay inputs
-        if (!replay_player.get_next_frame(p1_buttons, p2_buttons)) {
-            // Replay finished or not playing
-            p1_buttons = 0;
-            p2_buttons = 0;
-        }
-        
-        // Set controller inputs from replay
-        emu.set_controller(0, p1_buttons);
-        emu.set_controller(1, p2_buttons);
-        
-        // Don't record when playing back
-        return;
-    }
-    
-    // --- Normal input handling (not replay) ---
+// Read local pads (keyboard, virtual controls, game controllers) without touching the emulator
+void poll_local_input(const Uint8* keys, const VirtualJoystick& joystick, const std::vector<VirtualButton>& buttons, const std::vector<SDL_GameController*>& controllers, uint8_t& p1_buttons, uint8_t& p2_buttons) {
     // --- Player 1 ---
     p1_buttons = 0;
     
@@ -191,8 +222,6 @@ void handle_input(Emulator& emu, const Uint8* keys, const VirtualJoystick& joyst
         if (axisX > DEADZONE)  p1_buttons |= (1 << Input::BUTTON_RIGHT);
     }
     
-    emu.set_controller(0, p1_buttons);
-
     // --- Player 2 ---
     p2_buttons = 0;
 
@@ -229,7 +258,33 @@ void handle_input(Emulator& emu, const Uint8* keys, const VirtualJoystick& joyst
         if (axisX < -DEADZONE) p2_buttons |= (1 << Input::BUTTON_LEFT);
         if (axisX > DEADZONE)  p2_buttons |= (1 << Input::BUTTON_RIGHT);
     }
+}
 
+// Input Handling
+void handle_input(Emulator& emu, const Uint8* keys, const VirtualJoystick& joystick, const std::vector<VirtualButton>& buttons, const std::vector<SDL_GameController*>& controllers) {
+    // Check if we're playing back a replay
+    uint8_t p1_buttons = 0;
+    uint8_t p2_buttons = 0;
+    
+    if (replay_player.is_playing) {
+        // Use replay inputs
+        if (!replay_player.get_next_frame(p1_buttons, p2_buttons)) {
+            // Replay finished or not playing
+            p1_buttons = 0;
+            p2_buttons = 0;
+        }
+        
+        // Set controller inputs from replay
+        emu.set_controller(0, p1_buttons);
+        emu.set_controller(1, p2_buttons);
+        
+        // Don't record when playing back
+        return;
+    }
+    
+    // --- Normal input handling (not replay) ---
+    poll_local_input(keys, joystick, buttons, controllers, p1_buttons, p2_buttons);
+    emu.set_controller(0, p1_buttons);
     emu.set_controller(1, p2_buttons);
     
     // Record Inputs
@@ -322,20 +377,22 @@ struct QuickBall {
                         if (item.id == 0) { // Share
                              std::cout << "[QuickBall] Share: Not Implemented" << std::endl;
                         } else if (item.id == 1) { // Snapshot
-                             const uint8_t* fb = emu.get_framebuffer();
-                             std::vector<uint8_t> temp_fb(256 * 240 * 4);
-                             std::memcpy(temp_fb.data(), fb, temp_fb.size());
-                             SDL_Surface* ss = SDL_CreateRGBSurfaceWithFormatFrom(temp_fb.data(), 256, 240, 32, 256*4, SDL_PIXELFORMAT_RGBA32);
-                             if (ss) {
-                                 fs::path snap_dir = nes::get_app_dir() / "snapshots";
-                                 if (!fs::exists(snap_dir)) fs::create_directories(snap_dir);
-                                 auto now = std::chrono::system_clock::now();
-                                 auto in_time_t = std::chrono::system_clock::to_time_t(now);
-                                 std::stringstream ss_name;
-                                 ss_name << (snap_dir / "snapshot_").string() << std::put_time(std::localtime(&in_time_t), "%Y%m%d_%H%M%S") << ".bmp";
-                                 SDL_SaveBMP(ss, ss_name.str().c_str());
-                                 SDL_FreeSurface(ss);
-                                 std::cout << "[QuickBall] Snapshot saved: " << ss_name.str() << std::endl;
+                             if (presented_frame) {
+                                 int bpp = SDL_BYTESPERPIXEL(presented_format);
+                                 std::vector<uint8_t> temp_fb(256 * 240 * bpp);
+                                 std::memcpy(temp_fb.data(), presented_frame, temp_fb.size());
+                                 SDL_Surface* ss = SDL_CreateRGBSurfaceWithFormatFrom(temp_fb.data(), 256, 240, bpp * 8, 256 * bpp, presented_format);
+                                 if (ss) {
+                                     fs::path snap_dir = nes::get_app_dir() / "snapshots";
+                                     if (!fs::exists(snap_dir)) fs::create_directories(snap_dir);
+                                     auto now = std::chrono::system_clock::now();
+                                     auto in_time_t = std::chrono::system_clock::to_time_t(now);
+                                     std::stringstream ss_name;
+                                     ss_name << (snap_dir / "snapshot_").string() << std::put_time(std::localtime(&in_time_t), "%Y%m%d_%H%M%S") << ".bmp";
+                                     SDL_SaveBMP(ss, ss_name.str().c_str());
+                                     SDL_FreeSurface(ss);
+                                     std::cout << "[QuickBall] Snapshot saved: " << ss_name.str() << std::endl;
+                                 }
                              }
                         } else if (item.id == 3) { // Home
                             recorder.stop_recording();
@@ -537,15 +594,25 @@ extern "C" int SDL_main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Load Config (trước khi mở audio: sample rate lấy từ config)
+    config.load();
+
     SDL_AudioSpec want, have;
     SDL_zero(want);
-    want.freq = 44100;
+    want.freq = config.get_audio_sample_rate();
     want.format = AUDIO_F32;
     want.channels = 1;
-    want.samples = 2048;
+    want.samples = 512;
+    want.callback = audio_callback;
+    want.userdata = &audio_ring;
     
-    SDL_AudioDeviceID audio_device = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
-    if (audio_device != 0) SDL_PauseAudioDevice(audio_device, 0);
+    // Cho phép device trả rate gốc của nó: resampler của core chuyển thẳng sang rate đó,
+    // SDL không phải resample thêm lần nữa
+    SDL_AudioDeviceID audio_device = SDL_OpenAudioDevice(NULL, 0, &want, &have, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+    if (audio_device != 0) {
+        audio_rate.set_target_fill(static_cast<size_t>(have.freq) / 30);
+        SDL_PauseAudioDevice(audio_device, 0);
+    }
     
     // Enable text input for text fields
     SDL_StartTextInput();
@@ -556,7 +623,9 @@ extern "C" int SDL_main(int argc, char* argv[]) {
     SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
     if (!renderer) return 1;
 
-    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+    PixelFormat frame_format;
+    presented_format = choose_texture_format(renderer, frame_format);
+    SDL_Texture* texture = SDL_CreateTexture(renderer, presented_format, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
 
     // --- Font Setup ---
     FontSystem font_title, font_body, font_small;
@@ -571,10 +640,19 @@ extern "C" int SDL_main(int argc, char* argv[]) {
         std::cerr << "Failed to init discovery" << std::endl;
     }
 
-    // Load Config
-    config.load();
-
     Emulator emu;
+    if (audio_device != 0) {
+        emu.set_audio_output(have.freq, static_cast<Resampler::Quality>(config.get_audio_quality()));
+    }
+    emu.set_cdl_enabled(config.get_code_data_logger_enabled());
+    emu.set_sprite_limit_enabled(config.get_sprite_limit_enabled());
+    
+    // Single player runs on its own thread; this loop only does UI/input/present
+    EmuThread emu_thread;
+    emu_thread.set_pixel_format(frame_format);
+    emu_thread.set_auto_frame_skip(config.get_frame_skip_enabled());
+    emu_thread.on_frame_input = [](uint8_t p1, uint8_t p2) { recorder.record_frame(p1, p2); };
+    emu_thread.start(&emu, audio_device != 0 ? &audio_ring : nullptr, &audio_rate);
     HomeScene homeScene;
     homeScene.init(config.get_nickname()); // Initialize with nickname from config
     LobbyScene lobbyScene;
@@ -586,6 +664,7 @@ extern "C" int SDL_main(int argc, char* argv[]) {
     bool lobby_player2_connected = false;
     std::string lobby_rom_path = "";
     std::string lobby_rom_name = "";
+    uint64_t lobby_rom_hash = 0;
     std::string lobby_host_name = "";
     
     // Multiplayer Game State
@@ -611,6 +690,9 @@ extern "C" int SDL_main(int argc, char* argv[]) {
         std::filesystem::create_directories(data_dir);
     }
     std::string slots_file = (data_dir / "game_slots.txt").string();
+    std::string rom_library_file = (data_dir / "rom_library.bin").string();
+    rom_library.load(rom_library_file);
+    homeScene.rom_library = &rom_library;
     
     // Load slots đã lưu từ file (nếu có)
     std::vector<SlotManager::Slot> saved_slots;
@@ -621,19 +703,17 @@ extern "C" int SDL_main(int argc, char* argv[]) {
             slots[i].name = saved_slots[i].name;
             slots[i].occupied = true;
             
-            // Load cover image từ saved path hoặc tìm tự động
-            std::string cover_path = saved_slots[i].cover_path;
-            if (cover_path.empty() || !std::filesystem::exists(cover_path)) {
-                // Nếu không có cover path hoặc file không tồn tại, tìm tự động
-                cover_path = find_cover_image(saved_slots[i].rom_path);
-            }
-            
-            // Lưu cover_path vào slot
-            slots[i].cover_path = cover_path;
-            
-            if (!cover_path.empty()) {
-                slots[i].cover_texture = load_texture(renderer, cover_path);
-            }
+            // Cover được tìm (nếu saved path trống/không tồn tại) và decode trên worker
+            // của cover cache, texture được upload dần trong HomeScene::render
+            slots[i].cover_path = saved_slots[i].cover_path;
+            homeScene.cover_cache.request((int)i, saved_slots[i].rom_path, saved_slots[i].cover_path);
+        }
+        
+        // Hash song song các ROM mới / đã thay đổi (size, mtime), ROM không đổi dùng lại index
+        std::vector<std::string> slot_paths;
+        for (const auto& s : saved_slots) slot_paths.push_back(s.rom_path);
+        if (rom_library.update(slot_paths) > 0) {
+            rom_library.save(rom_library_file);
         }
     }
     
@@ -655,7 +735,7 @@ extern "C" int SDL_main(int argc, char* argv[]) {
             
             if (config.get_gameplay_recorder_enabled()) {
                 std::string rom_name = fs::path(path).filename().string();
-                recorder.start_recording(rom_name);
+                recorder.start_recording(rom_name, rom_library.update(path));
             }
             return true;
         }
@@ -674,7 +754,16 @@ extern "C" int SDL_main(int argc, char* argv[]) {
 
     homeScene.on_create_host = [&](std::string host_name, std::string rom_name, std::string rom_path) {
         std::cout << "🎮 Creating host: " << host_name << std::endl;
-        discovery.start_advertising(config.get_device_id(), host_name, rom_name, rom_path, 6503);
+        // Hash nội dung ROM (lấy từ library, chỉ hash lại nếu file đổi), gửi thay cho path
+        const nes::RomInfo* rom = rom_library.update(rom_path);
+        if (!rom) {
+            homeScene.toast_message = "Cannot read ROM: " + rom_name;
+            homeScene.toast_timer = SDL_GetTicks() + 3000;
+            return;
+        }
+        lobby_rom_hash = rom->hash64();
+        discovery.start_advertising(config.get_device_id(), host_name, rom_name, lobby_rom_hash, 6503);
+        net_manager.set_local_rom(lobby_rom_hash, rom_name);
         net_manager.start_host(6503);
         
         lobby_is_host = true;
@@ -692,11 +781,29 @@ extern "C" int SDL_main(int argc, char* argv[]) {
 
     homeScene.on_connect_host = [&](const NetworkDiscovery::Peer& host) {
         std::cout << "🔗 Connecting to host: " << host.username << std::endl;
+        // Tìm ROM cùng nội dung trong library (path trên máy này có thể khác host)
+        const nes::RomInfo* rom = rom_library.find_by_hash64(host.rom_hash);
+        if (!rom) {
+            homeScene.toast_message = "ROM mismatch: you don't have \"" + host.game_name + "\"";
+            homeScene.toast_timer = SDL_GetTicks() + 3000;
+            return;
+        }
+        // Index có thể cũ: hash lại nếu file đã đổi (size/mtime). Hello phải mang hash
+        // của file sẽ load chứ không phải hash host quảng bá, để host tự so khớp
+        std::string rom_path = rom->path;
+        rom = rom_library.update(rom_path);
+        if (!rom) {
+            homeScene.toast_message = "Cannot read ROM: " + rom_path;
+            homeScene.toast_timer = SDL_GetTicks() + 3000;
+            return;
+        }
         lobby_is_host = false;
-        lobby_rom_path = host.rom_path;
+        lobby_rom_path = rom->path;
         lobby_rom_name = host.game_name;
+        lobby_rom_hash = rom->hash64();
         lobby_host_name = host.username;
         
+        net_manager.set_local_rom(lobby_rom_hash, rom->title());
         net_manager.connect_to(host.ip, host.port);
         
         if (emu.load_rom(lobby_rom_path.c_str())) {
@@ -766,6 +873,10 @@ extern "C" int SDL_main(int argc, char* argv[]) {
     
     while (!quit) {
         auto frame_start = std::chrono::high_resolution_clock::now();
+        
+        // Emulator is shared with the emulation thread: hold the lock while events /
+        // scene logic may touch it. Released before UI drawing when the thread is running.
+        std::unique_lock<std::mutex> emu_lock = emu_thread.lock_emu();
 
         // Ensure we always have an empty slot for "Add ROM" in Home Screen
         if (current_scene == SCENE_HOME) {
@@ -784,11 +895,29 @@ extern "C" int SDL_main(int argc, char* argv[]) {
         // Poll network connection state in lobby
         if (current_scene == SCENE_LOBBY) {
             if (lobby_is_host) {
-                // Host: Check for P2 connection
+                // Host: Check for P2 connection (chỉ nhận khi handshake xác nhận cùng ROM)
                 if (net_manager.is_connected() && !lobby_player2_connected) {
-                    lobby_player2_connected = true;
-                    std::cout << "✅ Player 2 connected!" << std::endl;
+                    auto check = net_manager.get_rom_check();
+                    if (check == nes::NetworkManager::RomCheck::MATCH) {
+                        lobby_player2_connected = true;
+                        std::cout << "✅ Player 2 connected!" << std::endl;
+                    } else if (check == nes::NetworkManager::RomCheck::MISMATCH) {
+                        // Từ chối client và tiếp tục chờ người khác
+                        lobbyScene.chat_history.push_back({"System", "Rejected player: different ROM (" + net_manager.get_remote_rom_title() + ")"});
+                        if (lobbyScene.chat_history.size() > lobbyScene.MAX_CHAT_MESSAGES) {
+                            lobbyScene.chat_history.erase(lobbyScene.chat_history.begin());
+                        }
+                        net_manager.disconnect();
+                        net_manager.start_host(6503);
+                    }
                 }
+            } else if (net_manager.get_rom_check() == nes::NetworkManager::RomCheck::MISMATCH) {
+                // Client: host chạy ROM khác, báo lỗi trước khi vào game
+                homeScene.toast_message = "ROM mismatch: host is running \"" + net_manager.get_remote_rom_title() + "\"";
+                homeScene.toast_timer = SDL_GetTicks() + 4000;
+                net_manager.disconnect();
+                lobby_player2_connected = false;
+                current_scene = SCENE_HOME;
             } else {
                 // Client: Check for START signal from host
                 nes::NetworkManager::Packet start_packet;
@@ -885,7 +1014,7 @@ extern "C" int SDL_main(int argc, char* argv[]) {
                     if (is_in_circle(mx, my, start_x, bottom_y, btn_radius)) {
                         if (replay_player.is_playing) {
                              replay_player.pause_playback();
-                             if (audio_device != 0) SDL_ClearQueuedAudio(audio_device);
+                             clear_audio(audio_device);
                         }
                         else replay_player.resume_playback();
                     }
@@ -953,6 +1082,12 @@ extern "C" int SDL_main(int argc, char* argv[]) {
             }
 
         }
+        
+        // Emulation only free-runs inside the game scene
+        if (current_scene != SCENE_GAME) {
+            emu_thread.set_running(false);
+            emu_thread.set_fast_forward(false);
+        }
 
         SDL_SetRenderDrawColor(renderer, 240, 240, 240, 255); // White BG
         SDL_RenderClear(renderer);
@@ -996,12 +1131,21 @@ extern "C" int SDL_main(int argc, char* argv[]) {
             const Uint8* currentKeyStates = SDL_GetKeyboardState(NULL);
             // handle_input(emu, currentKeyStates, joystick, buttons, connected_controllers); // REMOVED from here
             
-            // Handle Playback Speed Logic
-            // Handle Playback Speed Logic
             bool emulator_ran = false;
-
-            // Handle Playback Speed Logic
-            if (replay_player.is_playing) {
+            
+            // Single player free-runs on the emulation thread.
+            // Replay and lockstep netplay step frames from this loop.
+            bool threaded = replay_player.frames.empty() && !multiplayer_active;
+            emu_thread.set_running(threaded);
+            // Hold Tab: run uncapped (cutscenes, grinding)
+            emu_thread.set_fast_forward(threaded && currentKeyStates[SDL_SCANCODE_TAB]);
+
+            if (threaded) {
+                uint8_t p1_buttons, p2_buttons;
+                poll_local_input(currentKeyStates, joystick, buttons, connected_controllers, p1_buttons, p2_buttons);
+                emu_thread.input.post(p1_buttons, p2_buttons);
+            } else if (replay_player.is_playing) {
+                // Handle Playback Speed Logic
                 // Only run replay if QuickBall is NOT expanded
                 if (!quickBall.expanded) {
                     float speed = replay_player.playback_speed;
@@ -1020,7 +1164,7 @@ extern "C" int SDL_main(int argc, char* argv[]) {
                         // If replay finishes mid-loop, stop
                         if (!replay_player.is_playing) break; 
 
-                        emu.run_frame();
+                        emu_thread.step_frame();
                         emulator_ran = true;
                     }
                 }
@@ -1118,7 +1262,7 @@ extern "C" int SDL_main(int argc, char* argv[]) {
                          net_manager.send_input(multiplayer_frame_id, local_input, current_checksum);
                          
                          // Run frame
-                         emu.run_frame();
+                         emu_thread.step_frame();
                          emulator_ran = true;
                          multiplayer_frame_id++;
                          
@@ -1147,17 +1291,49 @@ extern "C" int SDL_main(int argc, char* argv[]) {
                          }
                      } else {
                          // Single player mode
-                         emu.run_frame();
+                         emu_thread.step_frame();
                          emulator_ran = true;
                      }
                 }
                 // If Paused Replay: Do nothing (freeze state)
             }
             
-            const uint8_t* framebuffer = emu.get_framebuffer();
-            SDL_UpdateTexture(texture, NULL, framebuffer, SCREEN_WIDTH * 4);
+            // UI work below no longer blocks the emulation thread
+            if (threaded) emu_lock.unlock();
+            
+            // Present the newest completed frame. It is already in the texture's format,
+            // so upload is a straight copy into the locked texture, limited to the span of
+            // scanlines that changed (skipped entirely for static frames / no new frame).
+            if (emu_thread.frames.acquire()) {
+                const uint8_t* framebuffer = emu_thread.frames.front();
+                presented_frame = framebuffer;
+                
+                const FrameTripleBuffer::DirtyRows& dirty = emu_thread.frames.front_dirty();
+                int first_row = SCREEN_HEIGHT, last_row = -1;
+                for (int y = 0; y < SCREEN_HEIGHT; y++) {
+                    if ((dirty[y >> 6] >> (y & 63)) & 1) {
+                        if (first_row > y) first_row = y;
+                        last_row = y;
+                    }
+                }
+                
+                void* tex_pixels;
+                int tex_pitch;
+                SDL_Rect rows = {0, first_row, SCREEN_WIDTH, last_row - first_row + 1};
+                if (last_row >= 0 && SDL_LockTexture(texture, &rows, &tex_pixels, &tex_pitch) == 0) {
+                    int row_bytes = SCREEN_WIDTH * emu_thread.bytes_per_pixel();
+                    for (int y = first_row; y <= last_row; y++) {
+                        std::memcpy(static_cast<uint8_t*>(tex_pixels) + (y - first_row) * tex_pitch, framebuffer + y * row_bytes, row_bytes);
+                    }
+                    SDL_UnlockTexture(texture);
+                }
+            }
             SDL_RenderCopy(renderer, texture, NULL, NULL);
             
+            if (emu_thread.is_fast_forward()) {
+                font_small.draw_text(renderer, ">> Fast Forward", 20, 30, {255, 255, 255, 255});
+            }
+            
             bool is_replaying = replay_player.is_playing || replay_player.get_current_frame() > 0;
             
             // Only update QuickBall position/layout if NOT replaying
@@ -1325,7 +1501,9 @@ extern "C" int SDL_main(int argc, char* argv[]) {
             
             if (audio_device != 0 && emulator_ran) {
                 const std::vector<float>& samples = emu.get_audio_samples();
-                if (!samples.empty()) SDL_QueueAudio(audio_device, samples.data(), samples.size() * sizeof(float));
+                if (!samples.empty()) audio_ring.push(samples.data(), samples.size());
+                // Tỉ lệ cho frame sau dựa theo mức đầy hiện tại
+                emu.set_audio_rate_ratio(audio_rate.update(audio_ring.size()));
             }
 
             // --- TIMER OVERLAY ---
@@ -1451,6 +1629,7 @@ extern "C" int SDL_main(int argc, char* argv[]) {
         }
     }
     SlotManager::save_slots(slots_file, slots_to_save);
+    rom_library.save(rom_library_file);
 
     font_title.cleanup();
     font_body.cleanup();
@@ -1459,6 +1638,7 @@ extern "C" int SDL_main(int argc, char* argv[]) {
     SDL_DestroyTexture(texture);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
+    emu_thread.stop();
     if (audio_device != 0) SDL_CloseAudioDevice(audio_device);
     discovery.shutdown();
     SDL_Quit();
@@ -0,0 +1,159 @@
+#include "../core/emulator.h"
+#include "disassembler.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace nes;
+
+// Chạy ROM headless với profiler rồi xuất báo cáo:
+//   - PC nóng nhất (theo cycles) kèm disassembly
+//   - Histogram opcode
+//   - Số lần truy cập thanh ghi PPU/APU
+// Cần build core với NES_PROFILER (cmake -DNES_PROFILER=ON)
+
+static const char* PPU_REG_NAMES[PROFILER_PPU_REGS] = {
+    "PPUCTRL", "PPUMASK", "PPUSTATUS", "OAMADDR",
+    "OAMDATA", "PPUSCROLL", "PPUADDR", "PPUDATA"
+};
+
+static const char* APU_REG_NAMES[PROFILER_APU_REGS] = {
+    "SQ1_VOL", "SQ1_SWEEP", "SQ1_LO", "SQ1_HI",
+    "SQ2_VOL", "SQ2_SWEEP", "SQ2_LO", "SQ2_HI",
+    "TRI_LINEAR", "-", "TRI_LO", "TRI_HI",
+    "NOISE_VOL", "-", "NOISE_LO", "NOISE_HI",
+    "DMC_FREQ", "DMC_RAW", "DMC_START", "DMC_LEN",
+    "OAMDMA", "SND_CHN", "JOY1", "JOY2/FRAME"
+};
+
+#ifdef NES_PROFILER
+static DisassembledInstruction disassemble_entry(Emulator& emu, const ProfileEntry& entry) {
+    if (entry.bank == PROFILER_RAM_BANK) {
+        return Disassembler::disassemble(entry.pc, &emu.memory_);
+    }
+
+    // Lấy bytes từ đúng bank trong PRG ROM (bank có thể đang không được map)
+    const uint8_t* prg = emu.get_cartridge().get_prg_rom();
+    size_t prg_size = emu.get_cartridge().get_prg_size();
+    uint32_t offset = static_cast<uint32_t>(entry.bank) * 0x2000 + (entry.pc & 0x1FFF);
+    uint8_t bytes[3] = {0, 0, 0};
+    for (int i = 0; i < 3 && offset + i < prg_size; i++) {
+        bytes[i] = prg[offset + i];
+    }
+    return Disassembler::disassemble(entry.pc, bytes);
+}
+
+static void write_report(std::ostream& out, Emulator& emu, size_t max_entries) {
+    const Profiler& prof = emu.get_profiler();
+    double total = static_cast<double>(std::max<uint64_t>(prof.get_total_cycles(), 1));
+
+    out << "=== Guest Profile ===" << std::endl;
+    out << "Instructions: " << prof.get_total_instructions() << std::endl;
+    out << "Cycles:       " << prof.get_total_cycles() << std::endl << std::endl;
+
+    // Hot PCs
+    out << "--- Hot PCs (by cycles) ---" << std::endl;
+    out << "BANK  PC      CYCLES        %      INSTRUCTION" << std::endl;
+    for (const ProfileEntry& entry : prof.get_hot_spots(max_entries)) {
+        DisassembledInstruction inst = disassemble_entry(emu, entry);
+        if (entry.bank == PROFILER_RAM_BANK) {
+            out << "RAM   ";
+        } else {
+            out << std::setw(3) << std::setfill(' ') << std::dec << entry.bank << "   ";
+        }
+        out << "$" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << entry.pc
+            << std::dec << std::setfill(' ') << "  "
+            << std::setw(12) << entry.cycles << "  "
+            << std::fixed << std::setprecision(2) << std::setw(6) << (100.0 * entry.cycles / total) << "  "
+            << inst.to_string() << std::endl;
+    }
+    out << std::endl;
+
+    // Opcode histogram (sắp xếp theo cycles)
+    out << "--- Opcodes (by cycles) ---" << std::endl;
+    out << "OP  NAME    COUNT         CYCLES        %" << std::endl;
+    std::vector<int> opcodes;
+    for (int op = 0; op < 256; op++) {
+        if (prof.get_opcode_counts()[op] != 0) {
+            opcodes.push_back(op);
+        }
+    }
+    std::sort(opcodes.begin(), opcodes.end(), [&](int a, int b) {
+        return prof.get_opcode_cycles()[a] > prof.get_opcode_cycles()[b];
+    });
+    for (int op : opcodes) {
+        uint8_t bytes[3] = {static_cast<uint8_t>(op), 0, 0};
+        DisassembledInstruction inst = Disassembler::disassemble(0, bytes);
+        out << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << op
+            << std::dec << std::setfill(' ') << "  "
+            << std::left << std::setw(6) << inst.mnemonic << std::right << "  "
+            << std::setw(12) << prof.get_opcode_counts()[op] << "  "
+            << std::setw(12) << prof.get_opcode_cycles()[op] << "  "
+            << std::fixed << std::setprecision(2) << std::setw(6)
+            << (100.0 * prof.get_opcode_cycles()[op] / total) << std::endl;
+    }
+    out << std::endl;
+
+    // Register access
+    out << "--- Register access ---" << std::endl;
+    out << "ADDR   NAME          READS         WRITES" << std::endl;
+    for (int i = 0; i < PROFILER_PPU_REGS; i++) {
+        if (prof.get_ppu_reads()[i] == 0 && prof.get_ppu_writes()[i] == 0) continue;
+        out << "$" << std::hex << std::uppercase << (0x2000 + i) << std::dec << "  "
+            << std::left << std::setw(12) << PPU_REG_NAMES[i] << std::right
+            << std::setw(12) << prof.get_ppu_reads()[i] << "  "
+            << std::setw(12) << prof.get_ppu_writes()[i] << std::endl;
+    }
+    for (int i = 0; i < PROFILER_APU_REGS; i++) {
+        if (prof.get_apu_reads()[i] == 0 && prof.get_apu_writes()[i] == 0) continue;
+        out << "$" << std::hex << std::uppercase << (0x4000 + i) << std::dec << "  "
+            << std::left << std::setw(12) << APU_REG_NAMES[i] << std::right
+            << std::setw(12) << prof.get_apu_reads()[i] << "  "
+            << std::setw(12) << prof.get_apu_writes()[i] << std::endl;
+    }
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <rom_file> [frames] [report.txt] [top_n]" << std::endl;
+        return 1;
+    }
+
+#ifdef NES_PROFILER
+    int frames = (argc >= 3) ? std::atoi(argv[2]) : 3600;
+    size_t top_n = (argc >= 5) ? static_cast<size_t>(std::atoi(argv[4])) : 50;
+
+    Emulator emu;
+    if (!emu.load_rom(argv[1])) {
+        std::cerr << "Failed to load ROM" << std::endl;
+        return 1;
+    }
+    emu.reset();
+
+    for (int frame = 0; frame < frames; frame++) {
+        emu.run_frame();
+    }
+
+    if (argc >= 4) {
+        std::ofstream out(argv[3]);
+        if (!out) {
+            std::cerr << "Cannot create " << argv[3] << std::endl;
+            return 1;
+        }
+        write_report(out, emu, top_n);
+        std::cout << "Report written to " << argv[3] << std::endl;
+    } else {
+        write_report(std::cout, emu, top_n);
+    }
+    return 0;
+#else
+    (void)PPU_REG_NAMES;
+    (void)APU_REG_NAMES;
+    std::cerr << "Profiler not built in (configure with -DNES_PROFILER=ON)" << std::endl;
+    return 1;
+#endif
+}
@@ -0,0 +1,62 @@
+#include "../core/cartridge/rom_library.h"
+#include "../core/cartridge/rom_hash.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+using namespace nes;
+
+// ROM library tool: scan thư mục (song song), in định danh nội dung của từng ROM.
+// Chạy lại với cùng index file sẽ chỉ hash những file đã đổi size / mtime.
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <folder>... [-i index_file] [-j threads]" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> folders;
+    std::string index_file;
+    unsigned threads = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            index_file = argv[++i];
+        } else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else {
+            folders.push_back(argv[i]);
+        }
+    }
+
+    RomLibrary library;
+    if (!index_file.empty() && library.load(index_file)) {
+        std::cout << "Loaded index: " << library.size() << " entries" << std::endl;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t pruned = library.prune();
+    size_t hashed = library.scan(folders, threads);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (const RomInfo& info : library.entries()) {
+        std::cout << std::hex << std::setfill('0')
+                  << std::setw(8) << info.crc32 << "  " << Sha1::to_hex(info.sha1)
+                  << std::dec << std::setfill(' ')
+                  << "  mapper " << std::setw(3) << (int)info.mapper
+                  << "  PRG " << std::setw(3) << (int)info.prg_banks * 16 << "KB"
+                  << "  CHR " << std::setw(3) << (int)info.chr_banks * 8 << "KB"
+                  << ((info.flags & RomInfo::FLAG_BATTERY) ? "  battery" : "")
+                  << "  " << info.path << std::endl;
+    }
+
+    std::cout << library.size() << " ROMs, " << hashed << " hashed, " << pruned << " pruned in "
+              << std::fixed << std::setprecision(1) << ms << " ms" << std::endl;
+
+    if (!index_file.empty() && !library.save(index_file)) {
+        std::cerr << "Failed to save index: " << index_file << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -38,20 +38,15 @@ public:
         
         std::cout << "💾 Đang lưu slots vào: " << filename << std::endl;
         
-        // Lưu từng slot
+        // Lưu từng slot. Không stat lại ROM ở đây: load_slots đã lọc ROM không tồn tại,
+        // còn định danh / thay đổi nội dung do RomLibrary theo dõi
         int saved_count = 0;
         for (const auto& slot : slots) {
             if (slot.occupied) {
-                std::cout << "   - Checking slot: " << slot.name << " (" << slot.rom_path << ")" << std::endl;
-                // Check xem file ROM còn tồn tại không
-                if (std::filesystem::exists(slot.rom_path)) {
-                    file << slot.rom_path << "\n";
-                    file << slot.name << "\n";
-                    file << slot.cover_path << "\n";  // Lưu cover path
-                    saved_count++;
-                } else {
-                    std::cout << "⚠️  ROM không tồn tại, bỏ qua: " << slot.rom_path << std::endl;
-                }
+                file << slot.rom_path << "\n";
+                file << slot.name << "\n";
+                file << slot.cover_path << "\n";  // Lưu cover path
+                saved_count++;
             }
         }
         
@@ -0,0 +1,312 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Slot.h"
+#include "UISystem.h"
+#include "AppPath.h"
+
+namespace nes {
+
+// --- Cover Art Cache ---
+// Covers are resolved (find_cover_image), decoded (stbi) and scaled down to thumbnails on
+// a small worker pool. Thumbnails are kept on disk under cache/covers keyed by image path +
+// mtime, so later launches skip the PNG/JPG decode entirely. The render thread only creates
+// textures from finished thumbnails, a few per frame, under a time budget.
+class CoverCache {
+public:
+    static constexpr int THUMB_MAX = 256;   // Longest side of a thumbnail (slot cover is 180x190)
+    static constexpr uint32_t THUMB_MAGIC = 0x48544547;  // "GETH"
+    static constexpr uint32_t THUMB_VERSION = 1;
+
+    CoverCache() {
+        unsigned hw = std::thread::hardware_concurrency();
+        unsigned count = hw > 2 ? std::min(hw - 1, 4u) : 1u;
+        for (unsigned i = 0; i < count; i++) {
+            workers.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~CoverCache() {
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex);
+            stopping = true;
+            jobs.clear();
+        }
+        jobs_cv.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    CoverCache(const CoverCache&) = delete;
+    CoverCache& operator=(const CoverCache&) = delete;
+
+    // Render thread: queue a cover for slot `index`. If cover_path is empty or missing the
+    // worker falls back to find_cover_image(rom_path) and reports the path it found.
+    void request(int index, const std::string& rom_path, const std::string& cover_path) {
+        State& s = state(index);
+        s.generation++;
+        s.status = PENDING;
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex);
+            jobs.push_back({index, s.generation, rom_path, cover_path});
+        }
+        jobs_cv.notify_one();
+    }
+
+    // Render thread: forget the slot (deleted / cover changed). In-flight results are dropped.
+    void cancel(int index) {
+        State& s = state(index);
+        s.generation++;
+        s.status = IDLE;
+    }
+
+    // True once a request was made for the slot (pending, loaded or failed)
+    bool requested(int index) const {
+        return index >= 0 && index < (int)states.size() && states[index].status != IDLE;
+    }
+
+    // Render thread: turn finished thumbnails into textures. Stops once budget_ms is spent,
+    // at least one upload is always done so progress is guaranteed.
+    void upload(SDL_Renderer* renderer, std::vector<Slot>& slots, double budget_ms = 2.0) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        double ticks_per_ms = (double)SDL_GetPerformanceFrequency() / 1000.0;
+
+        while (true) {
+            Result r;
+            {
+                std::lock_guard<std::mutex> lock(results_mutex);
+                if (results.empty()) return;
+                r = std::move(results.front());
+                results.pop_front();
+            }
+
+            if (r.index >= (int)slots.size()) continue;
+            State& s = state(r.index);
+            if (r.generation != s.generation) continue;  // Stale: slot was cancelled or re-requested
+
+            Slot& slot = slots[r.index];
+            if (!r.cover_path.empty()) slot.cover_path = r.cover_path;
+            if (r.pixels.empty()) {
+                s.status = FAILED;
+                continue;
+            }
+
+            SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, r.w, r.h);
+            if (texture) {
+                SDL_UpdateTexture(texture, NULL, r.pixels.data(), r.w * 4);
+                SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            }
+            if (slot.cover_texture) SDL_DestroyTexture(slot.cover_texture);
+            slot.cover_texture = texture;
+            s.status = texture ? LOADED : FAILED;
+
+            if ((SDL_GetPerformanceCounter() - start) / ticks_per_ms >= budget_ms) return;
+        }
+    }
+
+private:
+    enum Status { IDLE, PENDING, LOADED, FAILED };
+
+    struct State {
+        uint32_t generation = 0;
+        Status status = IDLE;
+    };
+
+    struct Job {
+        int index;
+        uint32_t generation;
+        std::string rom_path;
+        std::string cover_path;
+    };
+
+    struct Result {
+        int index = -1;
+        uint32_t generation = 0;
+        std::string cover_path;     // Resolved path ("" = keep the slot's)
+        int w = 0, h = 0;
+        std::vector<uint8_t> pixels;  // RGBA, empty on failure
+    };
+
+    // States are only touched on the render thread
+    State& state(int index) {
+        if (index >= (int)states.size()) states.resize(index + 1);
+        return states[index];
+    }
+
+    void worker_loop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(jobs_mutex);
+                jobs_cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            Result r;
+            r.index = job.index;
+            r.generation = job.generation;
+
+            std::error_code ec;
+            std::string path = job.cover_path;
+            if (path.empty() || !std::filesystem::exists(path, ec)) {
+                path = find_cover_image(job.rom_path);
+                r.cover_path = path;
+            }
+            if (!path.empty()) load_thumbnail(path, r);
+
+            std::lock_guard<std::mutex> lock(results_mutex);
+            results.push_back(std::move(r));
+        }
+    }
+
+    // Disk cache hit → read thumbnail; miss → decode, scale, write back
+    static void load_thumbnail(const std::string& path, Result& r) {
+        std::error_code ec;
+        auto mtime = std::filesystem::last_write_time(path, ec);
+        if (ec) return;
+
+        uint64_t key = hash_key(path, (uint64_t)mtime.time_since_epoch().count());
+        std::filesystem::path cache_file = cache_dir() / (to_hex(key) + ".thumb");
+
+        if (read_cache(cache_file, key, r)) return;
+
+        int w, h, comp;
+        unsigned char* data = stbi_load(path.c_str(), &w, &h, &comp, 4);
+        if (!data) return;
+        scale_down(data, w, h, r);
+        stbi_image_free(data);
+
+        write_cache(cache_file, key, r);
+    }
+
+    // Box filter: each thumbnail pixel averages the source pixels it covers.
+    // Images already within THUMB_MAX are copied as-is.
+    static void scale_down(const uint8_t* src, int w, int h, Result& r) {
+        int longest = std::max(w, h);
+        if (longest <= THUMB_MAX) {
+            r.w = w; r.h = h;
+            r.pixels.assign(src, src + (size_t)w * h * 4);
+            return;
+        }
+        r.w = std::max(1, (int)((int64_t)w * THUMB_MAX / longest));
+        r.h = std::max(1, (int)((int64_t)h * THUMB_MAX / longest));
+        r.pixels.resize((size_t)r.w * r.h * 4);
+
+        for (int ty = 0; ty < r.h; ty++) {
+            int y0 = (int)((int64_t)ty * h / r.h);
+            int y1 = std::max(y0 + 1, (int)((int64_t)(ty + 1) * h / r.h));
+            for (int tx = 0; tx < r.w; tx++) {
+                int x0 = (int)((int64_t)tx * w / r.w);
+                int x1 = std::max(x0 + 1, (int)((int64_t)(tx + 1) * w / r.w));
+                uint32_t sum[4] = {0, 0, 0, 0};
+                for (int y = y0; y < y1; y++) {
+                    const uint8_t* row = src + ((size_t)y * w + x0) * 4;
+                    for (int x = x0; x < x1; x++, row += 4) {
+                        sum[0] += row[0]; sum[1] += row[1]; sum[2] += row[2]; sum[3] += row[3];
+                    }
+                }
+                uint32_t n = (uint32_t)(y1 - y0) * (uint32_t)(x1 - x0);
+                uint8_t* dst = &r.pixels[((size_t)ty * r.w + tx) * 4];
+                for (int c = 0; c < 4; c++) dst[c] = (uint8_t)((sum[c] + n / 2) / n);
+            }
+        }
+    }
+
+    // File layout: magic, version, key (u64), w, h, then w*h RGBA
+    static bool read_cache(const std::filesystem::path& file, uint64_t key, Result& r) {
+        std::ifstream in(file, std::ios::binary);
+        if (!in) return false;
+        uint32_t magic = 0, version = 0, w = 0, h = 0;
+        uint64_t stored_key = 0;
+        in.read(reinterpret_cast<char*>(&magic), 4);
+        in.read(reinterpret_cast<char*>(&version), 4);
+        in.read(reinterpret_cast<char*>(&stored_key), 8);
+        in.read(reinterpret_cast<char*>(&w), 4);
+        in.read(reinterpret_cast<char*>(&h), 4);
+        if (!in || magic != THUMB_MAGIC || version != THUMB_VERSION || stored_key != key) return false;
+        if (w == 0 || h == 0 || w > THUMB_MAX || h > THUMB_MAX) return false;
+
+        r.w = (int)w; r.h = (int)h;
+        r.pixels.resize((size_t)w * h * 4);
+        in.read(reinterpret_cast<char*>(r.pixels.data()), r.pixels.size());
+        if (!in) {
+            r.pixels.clear();
+            return false;
+        }
+        return true;
+    }
+
+    // Written to a temp file and renamed so a crash never leaves a half-written thumbnail
+    static void write_cache(const std::filesystem::path& file, uint64_t key, const Result& r) {
+        std::error_code ec;
+        std::filesystem::create_directories(file.parent_path(), ec);
+        std::filesystem::path tmp = file;
+        tmp += ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            if (!out) return;
+            uint32_t w = (uint32_t)r.w, h = (uint32_t)r.h;
+            out.write(reinterpret_cast<const char*>(&THUMB_MAGIC), 4);
+            out.write(reinterpret_cast<const char*>(&THUMB_VERSION), 4);
+            out.write(reinterpret_cast<const char*>(&key), 8);
+            out.write(reinterpret_cast<const char*>(&w), 4);
+            out.write(reinterpret_cast<const char*>(&h), 4);
+            out.write(reinterpret_cast<const char*>(r.pixels.data()), r.pixels.size());
+            if (!out) {
+                out.close();
+                std::filesystem::remove(tmp, ec);
+                return;
+            }
+        }
+        std::filesystem::rename(tmp, file, ec);
+        if (ec) std::filesystem::remove(tmp, ec);
+    }
+
+    static std::filesystem::path cache_dir() {
+        return nes::get_app_dir() / "cache" / "covers";
+    }
+
+    // FNV-1a over path bytes, mtime and thumbnail size
+    static uint64_t hash_key(const std::string& path, uint64_t mtime) {
+        uint64_t h = 1469598103934665603ULL;
+        auto mix = [&h](uint8_t b) { h ^= b; h *= 1099511628211ULL; };
+        for (char c : path) mix((uint8_t)c);
+        for (int i = 0; i < 8; i++) mix((uint8_t)(mtime >> (i * 8)));
+        for (int i = 0; i < 4; i++) mix((uint8_t)((uint32_t)THUMB_MAX >> (i * 8)));
+        return h;
+    }
+
+    static std::string to_hex(uint64_t v) {
+        static const char digits[] = "0123456789abcdef";
+        std::string s(16, '0');
+        for (int i = 15; i >= 0; i--, v >>= 4) s[i] = digits[v & 0xF];
+        return s;
+    }
+
+    std::vector<State> states;
+
+    std::mutex jobs_mutex;
+    std::condition_variable jobs_cv;
+    std::deque<Job> jobs;
+    bool stopping = false;
+
+    std::mutex results_mutex;
+    std::deque<Result> results;
+
+    std::vector<std::thread> workers;
+};
+
+} // namespace nes
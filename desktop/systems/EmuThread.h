@@ -0,0 +1,319 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../../core/emulator.h"
+#include "../../core/apu/audio_ring.h"
+
+// --- Triple Buffered Framebuffer ---
+// The PPU renders straight into back() (in the texture's pixel format), publish() hands it over.
+// Render thread calls acquire() to get the newest completed frame.
+// Neither side ever waits for the other; stale frames are simply dropped.
+// Each frame carries the scanlines that changed since the last frame the reader took,
+// so the reader can upload only those rows.
+class FrameTripleBuffer {
+public:
+    static constexpr size_t FRAME_BYTES = 256 * 240 * 4;
+    using DirtyRows = std::array<uint64_t, 4>;
+
+    FrameTripleBuffer() : back_index(0), front_index(1), middle_state(2) {
+        for (auto& b : buffers) b.assign(FRAME_BYTES, 0);
+        for (auto& d : dirty) d.fill(~0ULL);
+        carry.fill(0);
+    }
+
+    uint8_t* back() { return buffers[back_index].data(); }
+
+    // Writer: swap back <-> middle and mark middle as fresh.
+    // frame_dirty = rows that differ from the previously published frame.
+    void publish(const DirtyRows& frame_dirty) {
+        DirtyRows& published = dirty[back_index];
+        for (int i = 0; i < 4; i++) published[i] = carry[i] | frame_dirty[i];
+
+        uint8_t old = middle_state.exchange(back_index | FRESH_BIT, std::memory_order_acq_rel);
+        back_index = old & INDEX_MASK;
+
+        // Previous frame was dropped (never acquired): its rows still have to reach the
+        // reader, so keep accumulating. Otherwise only this frame's rows are pending.
+        carry = (old & FRESH_BIT) ? published : frame_dirty;
+    }
+
+    // Reader: if a new frame is ready, swap it to front. Returns true if front changed.
+    bool acquire() {
+        if (!(middle_state.load(std::memory_order_acquire) & FRESH_BIT)) return false;
+        uint8_t old = middle_state.exchange(front_index, std::memory_order_acq_rel);
+        front_index = old & INDEX_MASK;
+        return true;
+    }
+
+    const uint8_t* front() const { return buffers[front_index].data(); }
+
+    // Writer: true while the last published frame has not been taken by the reader yet
+    bool pending() const { return (middle_state.load(std::memory_order_acquire) & FRESH_BIT) != 0; }
+
+    // Rows of front() that differ from the frame acquired before it
+    const DirtyRows& front_dirty() const { return dirty[front_index]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x03;
+    static constexpr uint8_t FRESH_BIT = 0x04;
+
+    std::vector<uint8_t> buffers[3];
+    DirtyRows dirty[3];
+    DirtyRows carry;                    // Owned by writer
+    uint8_t back_index;                 // Owned by writer
+    uint8_t front_index;                // Owned by reader
+    std::atomic<uint8_t> middle_state;  // Shared: index | FRESH_BIT
+};
+
+// --- Input Mailbox ---
+// Render thread posts the latest pad state, emulation thread reads it once per frame.
+// Both controllers packed in one word so a frame never sees a half-updated pair.
+class InputMailbox {
+public:
+    void post(uint8_t p1, uint8_t p2) {
+        state.store(static_cast<uint16_t>(p1 | (p2 << 8)), std::memory_order_release);
+    }
+
+    void read(uint8_t& p1, uint8_t& p2) const {
+        uint16_t s = state.load(std::memory_order_acquire);
+        p1 = s & 0xFF;
+        p2 = s >> 8;
+    }
+
+private:
+    std::atomic<uint16_t> state{0};
+};
+
+// --- Emulation Thread ---
+// Runs Emulator::run_frame at the NTSC rate on its own clock, independent of UI work
+// and display refresh rate. Any other thread touching the Emulator must hold
+// emu_mutex() (frames run with it held, so the lock waits at most one frame).
+//
+// Fast-forward drops the clock and runs frames back to back. Only frames the display
+// can still show get pixels: while the reader has not taken the last published frame,
+// frames run with PPU pixel output off and are not published. Audio keeps real-time
+// length by dropping whole frames of samples while the ring is at its target fill
+// (granular time-stretch, pitch unchanged), with a short ramp over each splice.
+//
+// Auto frame skip (weak devices) keeps the NTSC clock but runs a frame hidden when
+// the thread is already behind its deadline or rendered frames cost more than the
+// frame budget. Hidden frames only drop pixel output; game state is unaffected.
+class EmuThread {
+public:
+    FrameTripleBuffer frames;
+    InputMailbox input;
+
+    // Called on the emulation thread before each frame with the pad state used
+    // for that frame (replay recorder hooks in here)
+    std::function<void(uint8_t, uint8_t)> on_frame_input;
+
+    ~EmuThread() { stop(); }
+
+    void start(nes::Emulator* emulator, nes::AudioRing* ring, nes::AudioRateControl* rate) {
+        if (worker.joinable()) return;
+        emu = emulator;
+        audio_ring = ring;
+        audio_rate = rate;
+        quit = false;
+        worker = std::thread(&EmuThread::thread_main, this);
+    }
+
+    void stop() {
+        if (!worker.joinable()) return;
+        quit = true;
+        worker.join();
+    }
+
+    // Enable/disable free running (single player). While disabled the thread idles
+    // and the UI thread may run frames itself (replay, lockstep netplay).
+    void set_running(bool run) { running.store(run, std::memory_order_release); }
+    bool is_running() const { return running.load(std::memory_order_acquire); }
+
+    std::mutex& emu_mutex() { return mutex; }
+
+    // Lock emu_mutex() from another thread. While fast-forwarding the emulation thread
+    // re-locks right after each frame; registering as a waiter makes it step aside.
+    std::unique_lock<std::mutex> lock_emu() {
+        waiters.fetch_add(1, std::memory_order_acq_rel);
+        std::unique_lock<std::mutex> lock(mutex);
+        waiters.fetch_sub(1, std::memory_order_acq_rel);
+        return lock;
+    }
+
+    void set_auto_frame_skip(bool enabled) { auto_frame_skip.store(enabled, std::memory_order_release); }
+
+    // Frames run hidden since start (for an on-screen counter / diagnostics)
+    uint64_t get_skipped_frames() const { return skipped_frames.load(std::memory_order_relaxed); }
+
+    void set_fast_forward(bool enabled) { fast_forward.store(enabled, std::memory_order_release); }
+    bool is_fast_forward() const { return fast_forward.load(std::memory_order_acquire); }
+
+    // Pixel format the PPU writes into the frame buffers (match the SDL texture so
+    // upload is a plain copy with no conversion). Set before start().
+    void set_pixel_format(nes::PixelFormat format) { pixel_format = format; }
+    int bytes_per_pixel() const { return pixel_format == nes::PixelFormat::RGB565 ? 2 : 4; }
+
+    // Run one frame on the calling thread and publish it (replay / lockstep netplay).
+    // Thread must not be running and the caller must hold emu_mutex().
+    void step_frame() {
+        render_frame(true);
+    }
+
+private:
+    // NTSC: 1789773 Hz / 29780.5 cycles = 60.0988 fps
+    static constexpr double FRAME_SECONDS = 29780.5 / 1789773.0;
+    static constexpr int MAX_LATE_FRAMES = 3;  // Beyond this, resync instead of catching up
+    static constexpr size_t SPLICE_SAMPLES = 64;  // Ramp length where fast-forward audio was cut
+    static constexpr int MAX_FRAME_SKIP = 4;      // Always show at least every 5th frame
+    static constexpr double COST_SMOOTHING = 0.1; // EMA weight of the latest rendered frame cost
+
+    nes::Emulator* emu = nullptr;
+    nes::AudioRing* audio_ring = nullptr;
+    nes::AudioRateControl* audio_rate = nullptr;
+    nes::PixelFormat pixel_format = nes::PixelFormat::RGBA32;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::atomic<bool> quit{false};
+    std::atomic<bool> running{false};
+    std::atomic<bool> fast_forward{false};
+    std::atomic<int> waiters{0};
+    std::atomic<bool> auto_frame_skip{false};
+    std::atomic<uint64_t> skipped_frames{0};
+
+    // Frame skip state (emulation thread only)
+    double render_cost = 0.0;  // Seconds, smoothed, of frames run with pixel output
+    int skip_run = 0;          // Consecutive hidden frames
+
+    // Fast-forward audio state (emulation thread only)
+    float last_sample = 0.0f;
+    bool audio_cut = false;
+    std::vector<float> splice;
+
+    void thread_main() {
+        using clock = std::chrono::steady_clock;
+        const auto frame_period = std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(FRAME_SECONDS));
+        auto deadline = clock::now();
+
+        while (!quit.load(std::memory_order_acquire)) {
+            if (!running.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                deadline = clock::now();
+                continue;
+            }
+
+            // Starting more than half a frame after the deadline = falling behind
+            run_one_frame(clock::now() > deadline + frame_period / 2);
+
+            if (fast_forward.load(std::memory_order_acquire)) {
+                // Uncapped; resume normal pacing from whenever fast-forward ends
+                while (waiters.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+                deadline = clock::now();
+                continue;
+            }
+
+            // Absolute deadlines: sleep jitter does not accumulate into drift
+            deadline += frame_period;
+            auto now = clock::now();
+            if (now > deadline + frame_period * MAX_LATE_FRAMES) {
+                deadline = now;
+            } else {
+                std::this_thread::sleep_until(deadline);
+            }
+        }
+    }
+
+    // Auto frame skip: hide this frame when behind schedule or when rendering does
+    // not fit the budget, but never more than MAX_FRAME_SKIP in a row
+    bool skip_frame(bool late) const {
+        if (!auto_frame_skip.load(std::memory_order_acquire) || skip_run >= MAX_FRAME_SKIP) return false;
+        return late || render_cost > FRAME_SECONDS;
+    }
+
+    void run_one_frame(bool late) {
+        std::lock_guard<std::mutex> lock(mutex);
+        // The UI thread may have stopped us while we waited for the lock
+        if (!running.load(std::memory_order_acquire)) return;
+
+        uint8_t p1, p2;
+        input.read(p1, p2);
+        emu->set_controller(0, p1);
+        emu->set_controller(1, p2);
+        if (on_frame_input) on_frame_input(p1, p2);
+
+        bool fast = fast_forward.load(std::memory_order_acquire);
+        if (fast) {
+            render_frame(!frames.pending());
+        } else if (skip_frame(late)) {
+            render_frame(false);
+            skip_run++;
+            skipped_frames.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            auto start = std::chrono::steady_clock::now();
+            render_frame(true);
+            double cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            render_cost += (cost - render_cost) * COST_SMOOTHING;
+            skip_run = 0;
+        }
+
+        if (audio_ring) push_audio(fast);
+    }
+
+    void push_audio(bool fast) {
+        const std::vector<float>& samples = emu->get_audio_samples();
+        if (samples.empty()) return;
+
+        if (fast) {
+            size_t target = audio_rate ? audio_rate->get_target_fill() : audio_ring->capacity() / 2;
+            if (audio_ring->size() >= target) {
+                audio_cut = true;  // Enough queued for real time: drop this frame's audio
+                return;
+            }
+            emu->set_audio_rate_ratio(1.0);
+        }
+
+        if (audio_cut) {
+            // Ramp from the last sample played into the new chunk to avoid a click
+            splice.assign(samples.begin(), samples.end());
+            size_t n = std::min(SPLICE_SAMPLES, splice.size());
+            for (size_t i = 0; i < n; i++) {
+                float t = static_cast<float>(i + 1) / static_cast<float>(n + 1);
+                splice[i] = last_sample + (splice[i] - last_sample) * t;
+            }
+            audio_ring->push(splice.data(), splice.size());
+            audio_cut = false;
+        } else {
+            audio_ring->push(samples.data(), samples.size());
+        }
+        last_sample = samples.back();
+
+        if (!fast && audio_rate) emu->set_audio_rate_ratio(audio_rate->update(audio_ring->size()));
+    }
+
+    // PPU writes into the back buffer directly; restore its own buffer afterwards so
+    // code that still calls Emulator::get_framebuffer() never sees a frame slot.
+    // Dirty rows accumulate in the core across frames run elsewhere (ROM start-up
+    // frames), so taking them here covers everything since the last publish.
+    // Hidden frames write no pixels, so they leave the dirty rows untouched.
+    void render_frame(bool visible) {
+        if (!visible) {
+            emu->set_pixel_output_enabled(false);
+            emu->run_frame();
+            emu->set_pixel_output_enabled(true);
+            return;
+        }
+        emu->set_output_surface(frames.back(), 256 * bytes_per_pixel(), pixel_format);
+        emu->run_frame();
+        emu->set_output_surface(nullptr, 0, nes::PixelFormat::RGBA32);
+        frames.publish(emu->get_dirty_rows());
+        emu->clear_dirty_rows();
+    }
+};
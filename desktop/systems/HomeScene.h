@@ -12,6 +12,7 @@
 
 #include "Slot.h"
 #include "UISystem.h"
+#include "CoverCache.h"
 #include "FontSystem.h"
 #include "ReplaySystem.h"
 #include "../slot_manager.h" 
@@ -65,6 +66,12 @@ public:
     std::string toast_message = "";
     Uint32 toast_timer = 0;
 
+    // Cover thumbnails (decoded off the render thread)
+    CoverCache cover_cache;
+
+    // ROM content index (owned by main, used to match replays / added ROMs)
+    RomLibrary* rom_library = nullptr;
+
     // Callbacks
     std::function<bool(std::string)> on_start_game;
     std::function<void(int)> on_delete_slot; // Notify main if needed, or handle here? Main handles save on exit. But immediate delete?
@@ -127,6 +134,8 @@ public:
             // Tab 3: Duo
             else if (mx >= start_x + 2*tab_w && mx < start_x + 3*tab_w && my >= tab_y && my < tab_y + tab_h) {
                 active_panel = HOME_PANEL_FAVORITES;
+                // Hosts answer at once instead of at their next keepalive
+                discovery.query();
             }
             
             // --- Panel Specific ---
@@ -155,8 +164,8 @@ public:
                              if (!path.empty()) {
                                  std::string new_cover = import_cover_image(path, slots[context_menu_slot].name);
                                  slots[context_menu_slot].cover_path = new_cover;
-                                 slots[context_menu_slot].cover_texture = load_texture(NULL, new_cover); // Renderer needed? null for now, reload in render?
-                                 // Ideally we should pass renderer to handle_event or reload in render
+                                 // Old texture stays on screen until the new thumbnail is uploaded
+                                 cover_cache.request(context_menu_slot, slots[context_menu_slot].rom_path, new_cover);
                              }
                          } else if (clicked_item == 3) { // Delete
                              delete_candidate_index = context_menu_slot;
@@ -181,6 +190,7 @@ public:
                              slots[delete_candidate_index].rom_path = "";
                              slots[delete_candidate_index].name = "";
                              slots[delete_candidate_index].cover_path = "";
+                             cover_cache.cancel(delete_candidate_index);
                              if (slots[delete_candidate_index].cover_texture) {
                                   SDL_DestroyTexture(slots[delete_candidate_index].cover_texture);
                                   slots[delete_candidate_index].cover_texture = nullptr;
@@ -217,9 +227,10 @@ public:
                                  slots[i].occupied = true;
                                  slots[i].rom_path = path;
                                  slots[i].name = std::filesystem::path(path).stem().string();
-                                 std::string cover = find_cover_image(path);
-                                 slots[i].cover_path = cover;
-                                 // Texture load deferred to render or next frame
+                                 if (rom_library) rom_library->update(path);
+                                 slots[i].cover_path = "";
+                                 // Cover lookup + decode run on the cover cache workers
+                                 cover_cache.request((int)i, path, "");
                              }
                          } else if (slots[i].occupied) {
                              bool near_dots = (mx >= sx + slot_w - 45 && mx <= sx + slot_w && my >= sy && my <= sy + 55);
@@ -275,27 +286,48 @@ public:
                         // Check Play Icon
                         if (mx >= icon_x - 20 && mx <= icon_x + 20) {
                             // Play Replay
-                            std::string game_name_str = replay_files[i].game_name;
-                            // Need to find matching slot
-                             bool rom_found = false;
-                             for (const auto& slot : slots) {
-                                if (slot.occupied && (
-                                    game_name_str.find(slot.name) != std::string::npos ||
-                                    slot.name.find(game_name_str) != std::string::npos)) {
-                                    
-                                    if (emu.load_rom(slot.rom_path.c_str())) {
-                                        emu.reset();
-                                        for (int k = 0; k < 10; k++) emu.run_frame();
-                                        
-                                        replay_player.load_replay(replay_files[i].path);
-                                        replay_player.start_playback();
-                                        
-                                        if (on_start_replay) on_start_replay();
-                                        rom_found = true;
+                            if (!replay_player.load_replay(replay_files[i].path)) return;
+                            
+                            // Replay carries a ROM hash: find that exact content in the library, whatever the file is called
+                            std::string rom_path;
+                            const RomInfo* rom = nullptr;
+                            if (replay_player.has_rom_hash && rom_library) {
+                                rom = rom_library->find_by_sha1(replay_player.rom_sha1);
+                                if (rom) rom_path = rom->path;
+                            }
+                            // Old replay (no hash) or ROM not in the library yet: match a slot by name
+                            if (rom_path.empty()) {
+                                std::string game_name_str = replay_files[i].game_name;
+                                for (const auto& slot : slots) {
+                                    if (slot.occupied && (
+                                        game_name_str.find(slot.name) != std::string::npos ||
+                                        slot.name.find(game_name_str) != std::string::npos)) {
+                                        rom_path = slot.rom_path;
+                                        break;
                                     }
-                                    break;
                                 }
-                             }
+                                // Same name but different content would desync immediately, refuse it
+                                if (!rom_path.empty() && replay_player.has_rom_hash && rom_library) {
+                                    const RomInfo* named = rom_library->update(rom_path);
+                                    if (!named || std::memcmp(named->sha1, replay_player.rom_sha1, 20) != 0) {
+                                        toast_message = "ROM mismatch: replay was recorded on a different ROM";
+                                        toast_timer = SDL_GetTicks() + 3000;
+                                        replay_player.unload_replay();
+                                        return;
+                                    }
+                                }
+                            }
+                            
+                            if (!rom_path.empty() && emu.load_rom(rom_path.c_str())) {
+                                emu.reset();
+                                for (int k = 0; k < 10; k++) emu.run_frame();
+                                
+                                replay_player.start_playback();
+                                
+                                if (on_start_replay) on_start_replay();
+                            } else {
+                                replay_player.unload_replay();
+                            }
                         } 
                         // Check Delete Icon
                         else if (mx >= del_x - 20 && mx <= del_x + 20) {
@@ -369,13 +401,13 @@ public:
                       // Connect Buttons
                       int card_y = start_y + 40;
                       int hy = card_y + 180 + 50 + 50; // section_y (400) + 50 header margin = 450
+                      // Hold the snapshot: on_connect_host uses `host` across connect/load_rom
                       auto hosts = discovery.get_peers();
-                      for(const auto& host : hosts) {
+                      for(const auto& host : *hosts) {
                           // Connect button
                           SDL_Rect conn_btn = {content_x + content_width - 120, hy + 20, 100, 40};
                           if (mx >= conn_btn.x && mx <= conn_btn.x + conn_btn.w && my >= conn_btn.y && my <= conn_btn.y + conn_btn.h) {
-                              bool has_rom = false;
-                              for(auto&s:slots) if(s.occupied && s.rom_path == host.rom_path) has_rom = true;
+                              bool has_rom = rom_library && rom_library->find_by_hash64(host.rom_hash);
                               if(has_rom && on_connect_host) {
                                   on_connect_host(host);
                               }
@@ -406,6 +438,9 @@ public:
                 FontSystem& font_title, FontSystem& font_body, FontSystem& font_small,
                 int SCREEN_WIDTH, int SCREEN_HEIGHT, int SCALE) {
         
+        // Upload finished cover thumbnails, ~2ms per frame so scrolling never hitches
+        cover_cache.upload(renderer, slots, 2.0);
+        
         // --- HEADER TABS ---
         int tab_y = 85; 
         int tab_h = 1;
@@ -471,8 +506,8 @@ public:
                      font_body.draw_text(renderer, "Add ROM", sx + 60, sy + slot_h - 40, {34, 43, 50, 255});
                  } else if (slots[i].occupied) {
                      // Cover Art / Cartridge Rendering
-                     if (!slots[i].cover_texture && !slots[i].cover_path.empty()) {
-                         slots[i].cover_texture = load_texture(renderer, slots[i].cover_path);
+                     if (!slots[i].cover_texture && !slots[i].cover_path.empty() && !cover_cache.requested((int)i)) {
+                         cover_cache.request((int)i, slots[i].rom_path, slots[i].cover_path);
                      }
                      if (slots[i].cover_texture) {
                           int img_w, img_h;
@@ -748,18 +783,18 @@ public:
              section_y += 50;
              
              auto peers = discovery.get_peers();
-             if (peers.empty()) {
+             if (peers->empty()) {
                 font_body.draw_text(renderer, "Searching for nearby players...", content_x + 20, section_y + 30, {150, 150, 150, 255});
              } else {
                 int hy = section_y;
-                for (auto& h : peers) {
+                for (const auto& h : *peers) {
                     SDL_Rect hc = {content_x, hy, content_width, 80};
                     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); SDL_RenderFillRect(renderer, &hc);
                     SDL_SetRenderDrawColor(renderer, 235, 235, 235, 255); SDL_RenderDrawRect(renderer, &hc);
                     font_body.draw_text(renderer, h.username, content_x + 50, hy + 35, {34, 43, 50, 255});
                     font_small.draw_text(renderer, "Playing: " + h.game_name, content_x + 50, hy + 58, {120, 120, 120, 255});
                     
-                    bool has = false; for(auto&s:slots) if(s.occupied && s.rom_path == h.rom_path) has=true;
+                    bool has = rom_library && rom_library->find_by_hash64(h.rom_hash);
                     SDL_Rect cb = {content_x + content_width - 120, hy + 20, 100, 40};
                     SDL_SetRenderDrawColor(renderer, has ? 52 : 231, has ? 152 : 76, has ? 219 : 60, 255);
                     SDL_RenderFillRect(renderer, &cb);
@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -10,6 +11,7 @@
 #include <filesystem>
 #include <algorithm>
 #include "AppPath.h"
+#include "../../core/cartridge/rom_library.h"
 
 namespace fs = std::filesystem;
 
@@ -23,7 +25,7 @@ struct ReplayHeader {
     char signature[4] = {'N', 'E', 'S', 'R'}; // NES Replay
     uint32_t version = 1;
     uint32_t total_frames;
-    char rom_hash[32]; // Placeholder for ROM hash
+    char rom_hash[32] = {}; // Version 2+: SHA-1 (20 bytes) + CRC32 (4 bytes) of PRG/CHR, rest zero
 };
 
 struct ReplayFileInfo {
@@ -46,11 +48,20 @@ public:
     bool is_recording = false;
     std::vector<ReplayFrame> frames;
     std::string current_rom_name;
+    bool has_rom_hash = false;
+    uint8_t rom_sha1[20] = {};
+    uint32_t rom_crc32 = 0;
 
-    void start_recording(const std::string& rom_name) {
+    // rom = library entry of the running ROM (nullptr = unknown, replay saved without hash)
+    void start_recording(const std::string& rom_name, const nes::RomInfo* rom = nullptr) {
         is_recording = true;
         frames.clear();
         current_rom_name = rom_name;
+        has_rom_hash = rom != nullptr;
+        if (rom) {
+            std::memcpy(rom_sha1, rom->sha1, sizeof(rom_sha1));
+            rom_crc32 = rom->crc32;
+        }
         std::cout << "[Recorder] Started recording for: " << rom_name << std::endl;
     }
 
@@ -92,6 +103,11 @@ public:
         // Write Header
         ReplayHeader header;
         header.total_frames = (uint32_t)frames.size();
+        if (has_rom_hash) {
+            header.version = 2;
+            std::memcpy(header.rom_hash, rom_sha1, 20);
+            std::memcpy(header.rom_hash + 20, &rom_crc32, 4);
+        }
         outfile.write((char*)&header, sizeof(header));
 
         // Write Frames
@@ -111,6 +127,8 @@ public:
     std::vector<ReplayFrame> frames;
     size_t current_frame_index = 0;
     std::string replay_name;
+    bool has_rom_hash = false;   // False for version 1 replays (match ROM by name only)
+    uint8_t rom_sha1[20] = {};
     
     // Playback control
     float playback_speed = 1.0f; // 1.0 = Normal, 2.0 = 2x, 0.5 = 0.5x
@@ -131,6 +149,9 @@ public:
             return false;
         }
 
+        has_rom_hash = header.version >= 2;
+        if (has_rom_hash) std::memcpy(rom_sha1, header.rom_hash, 20);
+
         frames.resize(header.total_frames);
         infile.read((char*)frames.data(), header.total_frames * sizeof(ReplayFrame));
         infile.close();
@@ -179,6 +200,7 @@ public:
         if (is_playing) stop_playback();
         frames.clear();
         replay_name = "";
+        has_rom_hash = false;
     }
 
     void pause_playback() {